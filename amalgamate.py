@@ -112,6 +112,7 @@ def amalgamate_source( source_top_dir=None,
     source.add_text( "" )
     lib_json = "src/lib_json"
     source.add_file( os.path.join(lib_json, "json_tool.h") )
+    source.add_file( os.path.join(lib_json, "json_doubleparser.h") )
     source.add_file( os.path.join(lib_json, "json_reader.cpp") )
     source.add_file( os.path.join(lib_json, "json_batchallocator.h") )
     source.add_file( os.path.join(lib_json, "json_valueiterator.inl") )
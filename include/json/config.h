@@ -26,6 +26,17 @@
 /// as if it was a POD) that may cause some validation tool to report errors.
 /// Only has effects if JSON_VALUE_USE_INTERNAL_MAP is defined.
 //#  define JSON_USE_SIMPLE_INTERNAL_ALLOCATOR 1
+/// If defined, the members of an object are stored in a vector sorted by name
+/// instead of a std::map: one allocation per object instead of one per
+/// member, and faster lookups and iteration, but adding a member to a large
+/// object moves the members after it. Has no effect with
+/// JSON_VALUE_USE_INTERNAL_MAP.
+//#  define JSON_VALUE_USE_FLAT_MAP 1
+/// If defined, Value does not store the range of the JSON text it was read
+/// from, which makes it 16 bytes smaller on 64-bit platforms:
+/// Value::getOffsetStart() and Value::getOffsetLimit() then return 0, and the
+/// errors added by Reader::pushError() refer to the start of the document.
+//#  define JSON_VALUE_NO_OFFSETS 1
 
 // If non-zero, the library uses exceptions to report bad input instead of C
 // assertion macros. The default is to use exceptions.
@@ -50,8 +50,70 @@ public:
 
   /// \c true if numeric object key are allowed. Default: \c false.
   bool allowNumericKeys_;
+
+  /// Maximum nesting depth of arrays and objects. Default: \c 1000.
+  unsigned maxDepth_;
+
+  /// \c true if strings may contain invalid UTF-8 sequences, which are then
+  /// copied as they are. Default: \c true.
+  bool allowInvalidUTF8_;
+
+  /// \c true if the range of the text each Value was read from is stored in
+  /// the Value, see Value::getOffsetStart(). Ignored if the library is built
+  /// with JSON_VALUE_NO_OFFSETS. Default: \c true.
+  bool storeOffsets_;
+};
+
+/** \brief Feature policy of BasicReader reading the features from a Features
+ * object while parsing.
+ */
+class JSON_API RuntimeFeatures {
+public:
+  RuntimeFeatures(const Features& features = Features())
+      : features_(features) {}
+
+  bool allowComments() const { return features_.allowComments_; }
+  bool strictRoot() const { return features_.strictRoot_; }
+  bool allowDroppedNullPlaceholders() const {
+    return features_.allowDroppedNullPlaceholders_;
+  }
+  bool allowNumericKeys() const { return features_.allowNumericKeys_; }
+  unsigned maxDepth() const { return features_.maxDepth_; }
+  bool allowInvalidUTF8() const { return features_.allowInvalidUTF8_; }
+  bool storeOffsets() const { return features_.storeOffsets_; }
+
+private:
+  Features features_;
 };
 
+/** \brief Feature policy of BasicReader fixing the features at compile time.
+ *
+ * The parser does not test the features while parsing, and the code of the
+ * features that are turned off is removed by the compiler.
+ */
+template <bool AllowComments,
+          bool StrictRoot,
+          bool AllowDroppedNullPlaceholders,
+          bool AllowNumericKeys,
+          unsigned MaxDepth = 1000,
+          bool AllowInvalidUTF8 = true,
+          bool StoreOffsets = true>
+class StaticFeatures {
+public:
+  bool allowComments() const { return AllowComments; }
+  bool strictRoot() const { return StrictRoot; }
+  bool allowDroppedNullPlaceholders() const {
+    return AllowDroppedNullPlaceholders;
+  }
+  bool allowNumericKeys() const { return AllowNumericKeys; }
+  unsigned maxDepth() const { return MaxDepth; }
+  bool allowInvalidUTF8() const { return AllowInvalidUTF8; }
+  bool storeOffsets() const { return StoreOffsets; }
+};
+
+/// The features of Features::strictMode().
+typedef StaticFeatures<false, true, false, false> StrictFeatures;
+
 } // namespace Json
 
 #endif // CPPTL_JSON_FEATURES_H_INCLUDED
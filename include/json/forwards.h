@@ -17,7 +17,16 @@ class FastWriter;
 class StyledWriter;
 
 // reader.h
+template <class Policy> class BasicReader;
 class Reader;
+class ReaderHandler;
+class JsonCursor;
+class IncrementalReader;
+class MappedDocument;
+class LinesReader;
+class ParallelReader;
+class LazyDocument;
+class LazyValue;
 
 // features.h
 class Features;
@@ -25,6 +34,7 @@ class Features;
 // value.h
 typedef unsigned int ArrayIndex;
 class StaticString;
+class KeyTable;
 class Path;
 class PathArgument;
 class Value;
@@ -24,11 +24,94 @@
 
 namespace Json {
 
-/** \brief Unserialize a <a HREF="http://www.json.org">JSON</a> document into a
- *Value.
+/** \brief Receives the events of a SAX-style parse.
  *
+ * Pass an instance to Reader::parse(const char*, const char*, ReaderHandler&)
+ * or to IncrementalReader to process a document without building a Value
+ * tree. The default
+ * implementation of each callback ignores the event, so a handler only needs
+ * to override the events it is interested in.
+ *
+ * Each callback returns \c true to continue parsing, or \c false to stop the
+ * parse immediately. Strings and member names are passed as a [begin, end)
+ * range of decoded UTF-8 text owned by the Reader, which is only valid until
+ * the callback returns.
  */
-class JSON_API Reader {
+class JSON_API ReaderHandler {
+public:
+  virtual ~ReaderHandler();
+
+  virtual bool null();
+  virtual bool boolean(bool value);
+  virtual bool integer(LargestInt value);
+  virtual bool unsignedInteger(LargestUInt value);
+  virtual bool real(double value);
+  virtual bool string(const char* begin, const char* end);
+
+  virtual bool startObject();
+  /// Called with the name of each member, before the events of its value.
+  virtual bool key(const char* begin, const char* end);
+  virtual bool endObject();
+
+  virtual bool startArray();
+  virtual bool endArray();
+};
+
+/** \brief Read-only memory mapping of a file, to parse a document without
+ * reading it into memory first.
+ *
+ * The file is mapped with sequential access advice, so the pages are read
+ * ahead as the parser reaches them and can be dropped once it is past them.
+ * Copies share the mapping, which is released when the last copy is closed
+ * or destroyed. When the library is built with threads (C++11), copies may be
+ * made and released on different threads. Otherwise the count of copies is
+ * not atomic, and all the copies of a document must stay on one thread.
+ *
+ * \code
+ * Json::MappedDocument document;
+ * if (document.open("data.json"))
+ *   reader.parse(document.begin(), document.end(), root);
+ * \endcode
+ * The offsets of the parsed values are relative to begin().
+ */
+class JSON_API MappedDocument {
+public:
+  MappedDocument();
+  MappedDocument(const MappedDocument& other);
+  MappedDocument& operator=(const MappedDocument& other);
+  ~MappedDocument();
+
+  /** \brief Maps the file at \a path, releasing the previous mapping.
+   * \return \c true if the file was mapped, \c false if it could not be
+   *         opened or mapped, in which case the document is closed.
+   */
+  bool open(const std::string& path);
+
+  /// Releases the mapping.
+  void close();
+
+  bool isOpen() const;
+  const char* begin() const;
+  const char* end() const;
+  size_t size() const;
+
+private:
+  class Mapping;
+
+  Mapping* mapping_;
+};
+
+/** \brief State and services of the <a HREF="http://www.json.org">JSON</a>
+ * readers that do not depend on the features they allow: tokenizer, decoding
+ * of scalar values and error reporting.
+ * \see BasicReader
+ */
+class JSON_API ReaderBase {
+  friend class JsonCursor;
+  friend class IncrementalReader;
+  friend class ParallelReader;
+  friend class LazyDocument;
+
 public:
   typedef char Char;
   typedef const Char* Location;
@@ -45,60 +128,6 @@ public:
     std::string message;
   };
 
-  /** \brief Constructs a Reader allowing all features
-   * for parsing.
-   */
-  Reader();
-
-  /** \brief Constructs a Reader allowing the specified feature set
-   * for parsing.
-   */
-  Reader(const Features& features);
-
-  /** \brief Read a Value from a <a HREF="http://www.json.org">JSON</a>
-   * document.
-   * \param document UTF-8 encoded string containing the document to read.
-   * \param root [out] Contains the root value of the document if it was
-   *             successfully parsed.
-   * \param collectComments \c true to collect comment and allow writing them
-   * back during
-   *                        serialization, \c false to discard comments.
-   *                        This parameter is ignored if
-   * Features::allowComments_
-   *                        is \c false.
-   * \return \c true if the document was successfully parsed, \c false if an
-   * error occurred.
-   */
-  bool
-  parse(const std::string& document, Value& root, bool collectComments = true);
-
-  /** \brief Read a Value from a <a HREF="http://www.json.org">JSON</a>
-   document.
-   * \param beginDoc Pointer on the beginning of the UTF-8 encoded string of the
-   document to read.
-   * \param endDoc Pointer on the end of the UTF-8 encoded string of the
-   document to read.
-   \               Must be >= beginDoc.
-   * \param root [out] Contains the root value of the document if it was
-   *             successfully parsed.
-   * \param collectComments \c true to collect comment and allow writing them
-   back during
-   *                        serialization, \c false to discard comments.
-   *                        This parameter is ignored if
-   Features::allowComments_
-   *                        is \c false.
-   * \return \c true if the document was successfully parsed, \c false if an
-   error occurred.
-   */
-  bool parse(const char* beginDoc,
-             const char* endDoc,
-             Value& root,
-             bool collectComments = true);
-
-  /// \brief Parse from input stream.
-  /// \see Json::operator>>(std::istream&, Json::Value&).
-  bool parse(std::istream& is, Value& root, bool collectComments = true);
-
   /** \brief Returns a user friendly string that list errors in the parsed
    * document.
    * \return Formatted error message with the list of errors with their location
@@ -153,7 +182,7 @@ public:
    */
   bool good() const;
 
-private:
+protected:
   enum TokenType {
     tokenEndOfStream = 0,
     tokenObjectBegin,
@@ -189,36 +218,965 @@ private:
 
   typedef std::deque<ErrorInfo> Errors;
 
+  ReaderBase();
+
   bool readToken();
   TokenType match(const Char* pattern, TokenType type);
   TokenType readCStyleComment();
   TokenType readCppStyleComment();
   TokenType readString();
   TokenType readNumber();
-  bool readValue(Value&);
-  bool readObject(Value&);
-  bool readArray(Value&);
+  bool decodeNumber(ReaderHandler&);
   bool decodeNumber(Value&);
   bool decodeDouble(Value&);
   bool decodeString(Value&);
   bool decodeString(std::string&);
+  bool decodeString(Char* decoded, size_t& length);
+  bool decodeStringInSitu(const char*& decoded, size_t& length);
+  bool decodeStringAllocated(char*& decoded, size_t& length);
   unsigned decodeUnicodeEscapeSequence(Location& current, Location end);
+  bool validateNumber();
+  bool validateString();
+  bool checkUTF8();
   void addError(const char* message, Location extra = 0);
   Char getNextChar();
   void getLocationLineAndColumn(Location, int& line, int& column) const;
   std::string getLocationLineAndColumn(Location location) const;
-  bool skipCommentTokens(std::string& queuedComments, Value* lastValue = 0);
 
   Errors errors_;
   std::string document_;
+  MappedDocument mappedDocument_;
   Location begin_;
   Location end_;
   Location current_;
   Location lastValueEnd_;
   Value* lastValue_;
   std::string commentsBefore_;
-  Features features_;
   bool collectComments_;
+  bool inSitu_;
+  bool reuse_;
+  bool validateUTF8_;
+  std::string stringBuffer_;
+};
+
+/** \brief Unserialize a <a HREF="http://www.json.org">JSON</a> document into a
+ * Value, with the features allowed by \a Policy.
+ *
+ * \a Policy is RuntimeFeatures, which tests a Features object while parsing,
+ * or a StaticFeatures instantiation whose features are known at compile time,
+ * so that the code of the disabled features is left out of the parser.
+ *
+ * The arrays and objects being read are kept on a stack allocated on the
+ * heap rather than by recursion, so the parse uses the same amount of
+ * machine stack whatever the nesting of the document. Documents nested deeper
+ * than the maxDepth() of \a Policy are rejected.
+ * The buffers used while parsing are kept by the reader and reused by the
+ * next parse, until reset() releases them.
+ * The parser is compiled in the library for RuntimeFeatures, used by Reader,
+ * and for StrictFeatures, used by StrictReader; no other instantiation is
+ * available.
+ */
+template <class Policy> class BasicReader : public ReaderBase {
+  friend class JsonCursor;
+  friend class IncrementalReader;
+  friend class ParallelReader;
+  friend class LazyDocument;
+
+public:
+  /** \brief Constructs a Reader allowing the features of \a policy
+   * for parsing.
+   */
+  BasicReader(const Policy& policy = Policy());
+
+  /** \brief Read a Value from a <a HREF="http://www.json.org">JSON</a>
+   * document.
+   * \param document UTF-8 encoded string containing the document to read.
+   * \param root [out] Contains the root value of the document if it was
+   *             successfully parsed.
+   * \param collectComments \c true to collect comment and allow writing them
+   * back during
+   *                        serialization, \c false to discard comments.
+   *                        This parameter is ignored if
+   * Features::allowComments_
+   *                        is \c false.
+   * \return \c true if the document was successfully parsed, \c false if an
+   * error occurred.
+   */
+  bool
+  parse(const std::string& document, Value& root, bool collectComments = true);
+
+  /** \brief Read a Value from a <a HREF="http://www.json.org">JSON</a>
+   document.
+   * \param beginDoc Pointer on the beginning of the UTF-8 encoded string of the
+   document to read.
+   * \param endDoc Pointer on the end of the UTF-8 encoded string of the
+   document to read.
+   \               Must be >= beginDoc.
+   * \param root [out] Contains the root value of the document if it was
+   *             successfully parsed.
+   * \param collectComments \c true to collect comment and allow writing them
+   back during
+   *                        serialization, \c false to discard comments.
+   *                        This parameter is ignored if
+   Features::allowComments_
+   *                        is \c false.
+   * \return \c true if the document was successfully parsed, \c false if an
+   error occurred.
+   */
+  bool parse(const char* beginDoc,
+             const char* endDoc,
+             Value& root,
+             bool collectComments = true);
+
+  /** \brief Read a Value from a <a HREF="http://www.json.org">JSON</a>
+   * document, referencing the strings of the document instead of copying them.
+   *
+   * The document is modified: each string and member name is decoded in place
+   * and terminated by a NUL character written over its closing quote. The
+   * resulting string values and member names point into the document, as if
+   * they were created from a StaticString, so parsing a string allocates no
+   * memory.
+   * Copying a string Value makes an owned copy of the string, but member
+   * names remain references when an object is copied.
+   * \param beginDoc Pointer on the beginning of the UTF-8 encoded document.
+   * \param endDoc Pointer on the end of the document. Must be >= beginDoc.
+   * \param root [out] Contains the root value of the document if it was
+   *             successfully parsed. The document must outlive \a root, and
+   *             every object copied from it.
+   * \param collectComments \c true to collect comment and allow writing them
+   *                        back during serialization, \c false to discard
+   *                        comments. This parameter is ignored if
+   *                        Features::allowComments_ is \c false.
+   * \return \c true if the document was successfully parsed, \c false if an
+   *         error occurred.
+   */
+  bool parseInSitu(char* beginDoc,
+                   char* endDoc,
+                   Value& root,
+                   bool collectComments = true);
+
+  /** \brief Read a Value from a <a HREF="http://www.json.org">JSON</a>
+   * document, updating the tree already in \a root.
+   *
+   * Where \a root has an array or an object of the same type at the same
+   * position as the document, it is kept, and its members are updated in
+   * place: the members read again keep their nodes, and string values
+   * already long enough keep their buffers. Members missing from the
+   * document are removed when their container ends, and the comments of the
+   * values kept are replaced by those of the document. Parsing documents of
+   * the same shape over the same tree thus mostly writes scalars in place,
+   * and allocates only for what changed.
+   * Member names are compared to the names in \a root, which must therefore
+   * be valid: if \a root was read by parseInSitu(), its document must still
+   * be alive.
+   * \param beginDoc Pointer on the beginning of the UTF-8 encoded document.
+   * \param endDoc Pointer on the end of the document. Must be >= beginDoc.
+   * \param root [in, out] Contains the root value of the document if it was
+   *             successfully parsed. If an error occurred, it may have been
+   *             partly updated.
+   * \param reuse \c false to discard the tree in \a root, as parse() does.
+   * \return \c true if the document was successfully parsed, \c false if an
+   *         error occurred.
+   */
+  bool parseInto(const char* beginDoc,
+                 const char* endDoc,
+                 Value& root,
+                 bool reuse = true);
+
+  /// \brief Read a Value from a document, updating the tree in \a root.
+  /// \see parseInto(const char*, const char*, Value&, bool)
+  bool parseInto(const std::string& document, Value& root, bool reuse = true);
+
+  /** \brief Parse a <a HREF="http://www.json.org">JSON</a> document without
+   * building a Value.
+   *
+   * The document is reported to \a handler as a sequence of events. Comments
+   * are skipped if Features::allowComments_ is \c true. Strings are decoded
+   * into a buffer that is reused for every string, so no memory is allocated
+   * per value once the buffer has grown to the longest string.
+   * \param beginDoc Pointer on the beginning of the UTF-8 encoded string of the
+   *                 document to read.
+   * \param endDoc Pointer on the end of the UTF-8 encoded string of the
+   *               document to read. Must be >= beginDoc.
+   * \param handler Receives the parse events.
+   * \return \c true if the document was successfully parsed, \c false if an
+   *         error occurred or if a callback of \a handler returned \c false.
+   *         In the latter case no error is recorded.
+   */
+  bool parse(const char* beginDoc, const char* endDoc, ReaderHandler& handler);
+
+  /** \brief Check that a document is valid
+   * <a HREF="http://www.json.org">JSON</a> without reading it.
+   *
+   * The document is checked against the same grammar and features as parse(),
+   * and the errors are reported the same way, but no Value is built, strings
+   * are checked without being decoded and comments are skipped, so no memory
+   * is allocated.
+   * \param beginDoc Pointer on the beginning of the UTF-8 encoded string of the
+   *                 document to check.
+   * \param endDoc Pointer on the end of the UTF-8 encoded string of the
+   *               document to check. Must be >= beginDoc.
+   * \return \c true if the document is valid, \c false if an error occurred.
+   */
+  bool validate(const char* beginDoc, const char* endDoc);
+
+  /** \brief Read only the values of a document selected by \a paths.
+   *
+   * Each path is resolved against the document as Path::resolve() resolves
+   * it against a Value, and the value it selects is stored in \a root at the
+   * same path, as by Path::make(). Values outside the paths are validated and
+   * skipped without building a Value, and parsing stops as soon as every path
+   * has been read or found missing, so the end of the document is neither
+   * read nor validated. Comments are not collected. When an object has
+   * several members of a selected name, the first one is read.
+   * \code
+   * std::vector<Json::Path> paths(1, Json::Path(".header"));
+   * if (reader.parse(begin, end, paths, root))
+   *   route(root["header"]);
+   * \endcode
+   * \param beginDoc Pointer on the beginning of the UTF-8 encoded string of the
+   *                 document to read.
+   * \param endDoc Pointer on the end of the UTF-8 encoded string of the
+   *               document to read. Must be >= beginDoc.
+   * \param paths Paths of the values to read.
+   * \param root [out] Contains the selected values if the document was
+   *             successfully parsed.
+   * \return \c true if the document was successfully parsed up to the last
+   *         selected value, \c false if an error occurred.
+   */
+  bool parse(const char* beginDoc,
+             const char* endDoc,
+             const std::vector<Path>& paths,
+             Value& root);
+
+  /// \brief Parse from input stream.
+  /// \see Json::operator>>(std::istream&, Json::Value&).
+  bool parse(std::istream& is, Value& root, bool collectComments = true);
+
+  /** \brief Read a Value from a <a HREF="http://www.json.org">JSON</a> file,
+   * parsing straight from a memory mapping of the file.
+   *
+   * The file is not copied: the reader keeps it mapped until it is destroyed
+   * or parses another file, so the offsets of the values and the error
+   * messages refer to the file.
+   * \param path Path of the UTF-8 encoded file to read.
+   * \param root [out] Contains the root value of the document if it was
+   *             successfully parsed.
+   * \param collectComments \c true to collect comment and allow writing them
+   *                        back during serialization, \c false to discard
+   *                        comments. This parameter is ignored if
+   *                        Features::allowComments_ is \c false.
+   * \return \c true if the document was successfully parsed, \c false if the
+   *         file could not be mapped or an error occurred.
+   * \see MappedDocument
+   */
+  bool parseFile(const std::string& path,
+                 Value& root,
+                 bool collectComments = true);
+
+  /** \brief Releases the memory kept by the reader between parses.
+   *
+   * A parse leaves its buffers to the next one: the copy of a document read
+   * from a string or a stream, the stack of open arrays and objects, the
+   * buffers of decoded strings and comments and the list of errors. Once they
+   * have grown to the size of the largest document, parsing more documents
+   * with the same reader allocates no memory besides the Values it builds.
+   * reset() frees those buffers, unmaps the last file read by parseFile() and
+   * forgets the errors of the last parse.
+   */
+  void reset();
+
+  /** \brief Names the members read after the copies interned in \a table.
+   *
+   * Instead of a copy of its own, each member of the objects read by parse()
+   * and parseInto() is named with the copy of its name held by \a table,
+   * which must therefore outlive the Values read. The members read by
+   * parseInSitu() are still named with the document. A \a table of 0, the
+   * default, stops sharing names.
+   * \see KeyTable
+   */
+  void setKeyTable(KeyTable* table);
+
+private:
+  bool readDocument(const char* beginDoc,
+                    const char* endDoc,
+                    Value& root,
+                    bool collectComments);
+  bool readDocument(const char* beginDoc,
+                    const char* endDoc,
+                    ReaderHandler& handler,
+                    bool decode);
+  bool readValue(Value&, size_t depth = 0);
+  bool readValue(ReaderHandler&, bool decode = true, size_t depth = 0);
+  bool abandonNodes();
+  bool storeOffsets() const {
+#ifndef JSON_VALUE_NO_OFFSETS
+    return policy_.storeOffsets();
+#else
+    return false;
+#endif
+  }
+  bool skipCommentTokens(std::string& queuedComments, Value* lastValue = 0);
+  void skipCommentTokens();
+
+  /// Progress of a parse selecting paths.
+  class Selection {
+  public:
+    Selection(const std::vector<Path>& paths, Value& root)
+        : paths_(paths), resolved_(paths.size()), remaining_(paths.size()),
+          root_(root) {}
+
+    const std::vector<Path>& paths_;
+    std::vector<bool> resolved_;
+    size_t remaining_;
+    Value& root_;
+  };
+
+  typedef std::vector<size_t> PathIndexes;
+
+  bool readSelection(Selection& selection,
+                     const PathIndexes& candidates,
+                     size_t depth);
+  void resolvePaths(Selection& selection, const PathIndexes& candidates);
+  bool skipValue(size_t depth);
+
+  /// An array or object being read, outermost first.
+  class Node {
+  public:
+    Node(Value* value, bool object, bool reused = false, size_t visited = 0)
+        : value_(value), lastValue_(0), visited_(visited), size_(0),
+          object_(object), reused_(reused) {}
+
+    Value* value_;
+    Value* lastValue_;
+    /// Index in BasicReader::visited_ of the first member of an object read
+    /// by a parseInto() that kept the object.
+    size_t visited_;
+    ArrayIndex size_;
+    bool object_;
+    bool reused_;
+  };
+
+  typedef std::vector<Node> Nodes;
+  typedef std::vector<const void*> Visited;
+
+  void retainMembers(const Node& node);
+
+  Policy policy_;
+  Nodes nodes_;
+  Visited visited_;
+  KeyTable* keyTable_;
+};
+
+/** \brief Unserialize a <a HREF="http://www.json.org">JSON</a> document into a
+ *Value.
+ *
+ */
+class JSON_API Reader : public BasicReader<RuntimeFeatures> {
+public:
+  /** \brief Constructs a Reader allowing all features
+   * for parsing.
+   */
+  Reader();
+
+  /** \brief Constructs a Reader allowing the specified feature set
+   * for parsing.
+   */
+  Reader(const Features& features);
+};
+
+/// Reader with the features of Features::strictMode() fixed at compile time.
+typedef BasicReader<StrictFeatures> StrictReader;
+
+/** \brief Forward-only pull parser over a <a HREF="http://www.json.org">JSON</a>
+ * document.
+ *
+ * The cursor walks the document one token at a time with the Reader
+ * tokenizer, validating the structure as it goes, and only decodes what the
+ * caller asks for. This makes it possible to pick a few members out of a large
+ * document, and to stop as soon as they have been found, without building a
+ * Value for the rest of it.
+ *
+ * Example of usage:
+ * \code
+ * Json::JsonCursor cursor(begin, end);
+ * Json::Value id;
+ * std::string name;
+ * cursor.next(); // the root object
+ * while (cursor.next() && cursor.type() == Json::JsonCursor::tokenKey) {
+ *   cursor.getString(name);
+ *   if (name == "id") {
+ *     cursor.next();
+ *     cursor.getValue(id);
+ *     break;
+ *   }
+ *   cursor.skipValue();
+ * }
+ * \endcode
+ *
+ * The document must remain alive while the cursor is used. Numbers and strings
+ * are only decoded, and checked, by getString() and getValue().
+ */
+class JSON_API JsonCursor {
+public:
+  enum TokenType {
+    tokenEndOfDocument = 0,
+    tokenObjectBegin,
+    tokenObjectEnd,
+    tokenArrayBegin,
+    tokenArrayEnd,
+    tokenKey,
+    tokenString,
+    tokenNumber,
+    tokenTrue,
+    tokenFalse,
+    tokenNull,
+    tokenError
+  };
+
+  /** \brief Constructs a cursor positioned before the first token of the
+   * document, allowing all features.
+   */
+  JsonCursor(const char* beginDoc, const char* endDoc);
+
+  /** \brief Constructs a cursor positioned before the first token of the
+   * document, allowing the specified feature set.
+   */
+  JsonCursor(const char* beginDoc, const char* endDoc, const Features& features);
+
+  /** \brief Advances to the next token.
+   * Comments are skipped. The ':' and ',' separators are consumed silently.
+   * \return \c true if the cursor is on a new token, \c false at the end of
+   *         the document or if an error occurred.
+   */
+  bool next();
+
+  /// Type of the token the cursor is on.
+  TokenType type() const;
+
+  /// Number of objects and arrays that enclose the current token.
+  /// The begin and end tokens of a container are at the depth of its parent.
+  unsigned depth() const;
+
+  /** \brief Skips the value starting at the current token.
+   * On a key, skips the value of that member. On an object or array begin,
+   * moves to the matching end token, so that the next call to next() returns
+   * the token that follows the container. Does nothing on a scalar.
+   * \return \c false if an error occurred.
+   */
+  bool skipValue();
+
+  /** \brief Decodes the current key or string token.
+   * \return \c false if the cursor is not on a key or string, or if the
+   *         string contains a bad escape sequence.
+   */
+  bool getString(std::string& value);
+
+  /** \brief Reads the value starting at the current token.
+   * Scalars are decoded in place. On an object or array begin the whole
+   * container is read into \a value and the cursor moves to its end token.
+   * On a key, \a value receives the member name.
+   * \return \c false if the cursor is not on a value or if an error occurred.
+   */
+  bool getValue(Value& value);
+
+  /// [start, limit) byte offsets of the current token in the document.
+  size_t getOffsetStart() const;
+  size_t getOffsetLimit() const;
+
+  /// \see Reader::good()
+  bool good() const;
+  /// \see Reader::getFormattedErrorMessages()
+  std::string getFormattedErrorMessages() const;
+  /// \see Reader::getStructuredErrors()
+  std::vector<Reader::StructuredError> getStructuredErrors() const;
+
+private:
+  enum Expect {
+    expectRoot = 0,
+    expectMember,
+    expectMemberSeparator,
+    expectElement,
+    expectSeparator,
+    expectEnd
+  };
+
+  void initialize(const char* beginDoc, const char* endDoc);
+  bool beginValue();
+  bool endContainer(TokenType type);
+  void endValue();
+  bool fail(const char* message);
+
+  Reader reader_;
+  std::vector<char> stack_;
+  TokenType type_;
+  Expect expect_;
+  /// No element or member has been read since the last container opened.
+  bool first_;
+  bool pending_;
+};
+
+/** \brief Resumable parser for a <a HREF="http://www.json.org">JSON</a>
+ * document received in chunks.
+ *
+ * Input is pushed with feed() as it becomes available, for example as packets
+ * arrive from a socket, and finish() is called once the end of the input is
+ * reached. All the parse state is kept between calls, so the document never
+ * has to be gathered into one buffer: only a token split across two chunks is
+ * copied.
+ *
+ * By default the parser builds a Value, returned by finish(Value&). It can
+ * also report the document to a ReaderHandler as it is parsed.
+ *
+ * \code
+ * Json::IncrementalReader reader;
+ * while (size_t size = receive(socket, buffer, sizeof(buffer)))
+ *   if (!reader.feed(buffer, size))
+ *     break;
+ * Json::Value root;
+ * if (!reader.finish(root))
+ *   std::cerr << reader.getFormattedErrorMessages();
+ * \endcode
+ *
+ * As with Reader, anything that follows the root value is ignored. Error
+ * offsets are counted in bytes from the start of the input.
+ */
+class JSON_API IncrementalReader {
+public:
+  /** \brief Constructs a parser that builds a Value, allowing all features
+   * for parsing.
+   */
+  IncrementalReader();
+
+  /** \brief Constructs a parser that builds a Value, allowing the specified
+   * feature set for parsing.
+   */
+  IncrementalReader(const Features& features);
+
+  /** \brief Constructs a parser that reports the document to \a handler,
+   * allowing the specified feature set for parsing.
+   */
+  IncrementalReader(ReaderHandler& handler,
+                    const Features& features = Features::all());
+
+  ~IncrementalReader();
+
+  /** \brief Parse the next chunk of the document.
+   * \param data Bytes following those passed to the previous calls.
+   * \param length Number of bytes in \a data. May be zero.
+   * \return \c false if an error occurred or if a callback of the handler
+   *         returned \c false, in which case the following chunks are
+   *         ignored; \c true otherwise.
+   */
+  bool feed(const char* data, size_t length);
+
+  /** \brief Signal the end of the input.
+   * \return \c true if a complete document was parsed.
+   */
+  bool finish();
+
+  /** \brief Signal the end of the input and retrieve the parsed Value.
+   * \param root [out] Contains the root value of the document if it was
+   *             successfully parsed. Always null when parsing to a handler.
+   * \return \c true if a complete document was parsed.
+   */
+  bool finish(Value& root);
+
+  /// Discard the parse state to start parsing a new document.
+  void reset();
+
+  /// Returns a user friendly string that list errors in the document.
+  std::string getFormattedErrorMessages() const;
+  /// Returns the errors encountered in the document.
+  std::vector<Reader::StructuredError> getStructuredErrors() const;
+  /// Return whether there are any errors.
+  bool good() const;
+
+private:
+  enum Status { statusParsing = 0, statusDone, statusStopped, statusFailed };
+  enum Expect {
+    expectRoot = 0,
+    expectMember,
+    expectMemberSeparator,
+    expectMemberValue,
+    expectElement,
+    expectSeparator,
+    expectEnd
+  };
+  enum Lexeme {
+    lexemeNone = 0,
+    lexemeString,
+    lexemeNumberIntegral,
+    lexemeNumberFraction,
+    lexemeNumberExponentSign,
+    lexemeNumberExponent,
+    lexemeLiteral,
+    lexemeCommentStart,
+    lexemeCStyleComment,
+    lexemeCppStyleComment
+  };
+
+  class ValueBuilder;
+
+  IncrementalReader(const IncrementalReader&);
+  IncrementalReader& operator=(const IncrementalReader&);
+
+  bool scanToken(const char*& current, const char* end);
+  void processToken(const char* begin, const char* end);
+  void beginValue(const char* begin, const char* end);
+  void endContainer();
+  void endValue();
+  bool decodeString(const char* begin, const char* end);
+  void prepareDecode(const char* begin, const char* end);
+  bool importErrors();
+  bool emit(bool result);
+  void fail(const char* message, size_t length);
+
+  Reader reader_;
+  ValueBuilder* builder_;
+  ReaderHandler* handler_;
+  std::vector<char> stack_;
+  std::string pending_;
+  std::vector<Reader::StructuredError> errors_;
+  size_t offset_;
+  size_t tokenOffset_;
+  const char* literal_;
+  Reader::TokenType token_;
+  Status status_;
+  Expect expect_;
+  Lexeme lexeme_;
+  /// No element or member has been read since the last container opened.
+  bool first_;
+  /// The last character scanned is a '\\' in a string or a '*' in a comment.
+  bool marker_;
+};
+
+/** \brief Parser for newline-delimited JSON (JSON Lines), parsing the lines on
+ * several threads.
+ *
+ * Each line that is not blank holds a record: one JSON document. The input is
+ * cut into blocks of whole lines, which worker threads claim one after the
+ * other and parse with a Reader of their own, so a thread that gets short
+ * lines takes more blocks. The records are returned in input order.
+ *
+ * \code
+ * Json::LinesReader reader;
+ * std::vector<Json::Value> records;
+ * if (!reader.parseFile("events.jsonl", records))
+ *   std::cerr << reader.getFormattedErrorMessages();
+ * \endcode
+ *
+ * A line that fails to parse gives a null record and its errors; the other
+ * lines are still parsed. Comments in the records are not collected.
+ * Threads are only used when the library is compiled as C++11 or later;
+ * otherwise the lines are parsed on the calling thread.
+ */
+class JSON_API LinesReader {
+public:
+  /// An error in one of the records.
+  struct StructuredError {
+    /// Index of the record in the parsed records.
+    size_t record;
+    /// Line of the record in the input, starting at 1. 0 if the input could
+    /// not be read.
+    size_t line;
+    /// Range of bytes of the error from the start of the input.
+    size_t offset_start;
+    size_t offset_limit;
+    std::string message;
+  };
+
+  /** \brief Constructs a parser allowing the specified feature set for
+   * parsing the records.
+   * \param threadCount Number of threads parsing the lines, counting the
+   *                    calling thread. 0 uses one thread per hardware thread.
+   */
+  LinesReader(const Features& features = Features::all(),
+              unsigned threadCount = 0);
+
+  /** \brief Parse the records of a buffer.
+   * \param beginDoc Pointer on the beginning of the UTF-8 encoded input.
+   * \param endDoc Pointer on the end of the input. Must be >= beginDoc.
+   * \param records [out] One Value per record, in input order.
+   * \return \c true if every record was successfully parsed.
+   */
+  bool parse(const char* beginDoc,
+             const char* endDoc,
+             std::vector<Value>& records);
+
+  /** \brief Parse the records of a file, from a memory mapping of the file.
+   * \return \c false if the file could not be mapped or if a record failed
+   *         to parse.
+   * \see MappedDocument
+   */
+  bool parseFile(const std::string& path, std::vector<Value>& records);
+
+  /// Returns a user friendly string that list errors in the records.
+  std::string getFormattedErrorMessages() const;
+  /// Returns the errors encountered in the records, in input order.
+  std::vector<StructuredError> getStructuredErrors() const;
+  /// Return whether there are any errors.
+  bool good() const;
+
+private:
+  class Block;
+
+  static void parseBlock(void* blocks, Reader& reader, size_t index);
+
+  Features features_;
+  unsigned threadCount_;
+  std::vector<StructuredError> errors_;
+};
+
+/** \brief Parser for a document made of one large array, parsing the elements
+ * on several threads.
+ *
+ * A first pass finds where the elements of the root array start and end,
+ * skipping strings and comments, and cuts them into blocks that threads claim
+ * one after the other, each parsing with a Reader of its own. The result,
+ * offsets included, is the same as that of Reader::parse() without comments.
+ *
+ * Documents whose root is not an array, or that are too small to gain from
+ * threads, are parsed by a single Reader. So are documents that fail to
+ * parse or use dropped null placeholders, so that the errors are those
+ * reported by Reader.
+ * Threads are only used when the library is compiled as C++11 or later.
+ */
+class JSON_API ParallelReader {
+public:
+  /** \brief Constructs a parser allowing the specified feature set for
+   * parsing.
+   * \param threadCount Number of threads parsing the elements, counting the
+   *                    calling thread. 0 uses one thread per hardware thread.
+   */
+  ParallelReader(const Features& features = Features::all(),
+                 unsigned threadCount = 0);
+
+  /** \brief Read a Value from a <a HREF="http://www.json.org">JSON</a>
+   * document. Comments are not collected.
+   * \param beginDoc Pointer on the beginning of the UTF-8 encoded document.
+   * \param endDoc Pointer on the end of the document. Must be >= beginDoc.
+   * \param root [out] Contains the root value of the document if it was
+   *             successfully parsed.
+   * \return \c true if the document was successfully parsed.
+   */
+  bool parse(const char* beginDoc, const char* endDoc, Value& root);
+
+  /// Returns a user friendly string that list errors in the document.
+  std::string getFormattedErrorMessages() const;
+  /// Returns the errors encountered in the document.
+  std::vector<Reader::StructuredError> getStructuredErrors() const;
+  /// Return whether there are any errors.
+  bool good() const;
+
+private:
+  class Block;
+
+  bool parseInParallel(const char* beginDoc, const char* endDoc, Value& root);
+  static void parseBlock(void* blocks, Reader& reader, size_t index);
+
+  Reader reader_;
+  Features features_;
+  unsigned threadCount_;
+};
+
+/** \brief Handle on a value of a LazyDocument.
+ *
+ * Navigating through operator[]() and iteration only reads the index of the
+ * document; value() builds a Value for the subtree when it is needed. A
+ * handle on a missing member or element has the type nullValue and refers to
+ * Value::null. Handles are valid as long as their document is.
+ *
+ * The first access to the elements or members of an array or object records
+ * where each of them starts. As this updates the document, a document must
+ * not be used from several threads at once.
+ */
+class JSON_API LazyValue {
+public:
+  /// Iterates over the elements of an array or the members of an object.
+  class JSON_API const_iterator {
+  public:
+    const_iterator();
+
+    LazyValue operator*() const;
+    const_iterator& operator++();
+    bool operator==(const const_iterator& other) const;
+    bool operator!=(const const_iterator& other) const;
+
+    /// Name of the member, or an empty string for an array element.
+    std::string name() const;
+
+  private:
+    friend class LazyValue;
+
+    const_iterator(const LazyDocument* document, size_t element);
+
+    const LazyDocument* document_;
+    /// Index of the element in LazyDocument::elements_.
+    size_t element_;
+  };
+
+  LazyValue();
+
+  ValueType type() const;
+  /** \brief Number of elements or members, 0 for other values.
+   * Members are counted as written, so duplicate names count twice; the same
+   * holds for getMemberNames().
+   */
+  ArrayIndex size() const;
+  bool isMember(const std::string& key) const;
+
+  /** \brief Access an object member, or a missing value if this is not an
+   * object or has no such member. With duplicate names, the last member wins
+   * as in Value.
+   */
+  LazyValue operator[](const std::string& key) const;
+  LazyValue operator[](const char* key) const;
+  /** \brief Access an array element, or a missing value if this is not an
+   * array or \a index is out of range. Takes constant time once the array
+   * has been accessed.
+   */
+  LazyValue operator[](ArrayIndex index) const;
+  LazyValue operator[](int index) const;
+
+  const_iterator begin() const;
+  const_iterator end() const;
+  Value::Members getMemberNames() const;
+
+  /** \brief Returns the value, building it on the first call.
+   * The Value is owned by the document. Comments are not collected.
+   */
+  const Value& value() const;
+
+  /// Offset of the value in the document, as Value::getOffsetStart().
+  size_t getOffsetStart() const;
+  /// Offset following the value in the document.
+  size_t getOffsetLimit() const;
+
+private:
+  friend class LazyDocument;
+
+  LazyValue(const LazyDocument* document,
+            size_t start,
+            size_t limit,
+            size_t node);
+  LazyValue member(const char* key, size_t length) const;
+
+  const LazyDocument* document_;
+  size_t start_;
+  size_t limit_;
+  /// Index of the array or object in LazyDocument::nodes_, or npos.
+  size_t node_;
+};
+
+/** \brief <a HREF="http://www.json.org">JSON</a> document parsed into an index
+ * of its values, from which Value objects are built only for the subtrees
+ * that are accessed.
+ *
+ * parse() validates the whole document, as Reader::validate() does, and
+ * records the byte range of every array and object in a flat array. Strings,
+ * numbers and member names are not decoded. Accessing an array or object
+ * then records where its elements start, so that accessing a few members of a
+ * large document through root() costs far less than building the whole Value
+ * tree.
+ *
+ * \code
+ * Json::LazyDocument document;
+ * if (document.parse(begin, end))
+ *   std::string user = document.root()["user"]["name"].value().asString();
+ * \endcode
+ */
+class JSON_API LazyDocument {
+public:
+  /** \brief Constructs a document allowing all features for parsing.
+   */
+  LazyDocument();
+
+  /** \brief Constructs a document allowing the specified feature set for
+   * parsing.
+   */
+  LazyDocument(const Features& features);
+
+  /** \brief Parse and index a document that is kept by the caller.
+   * \param beginDoc Pointer on the beginning of the UTF-8 encoded document.
+   *                 The document must outlive this object, or the next call
+   *                 to parse().
+   * \param endDoc Pointer on the end of the document. Must be >= beginDoc.
+   * \return \c true if the document was successfully parsed.
+   */
+  bool parse(const char* beginDoc, const char* endDoc);
+
+  /// Parse and index a copy of \a document.
+  bool parse(const std::string& document);
+
+  /// The root value, missing if the last parse failed.
+  LazyValue root() const;
+
+  /// Returns a user friendly string that list errors in the document.
+  std::string getFormattedErrorMessages() const;
+  /// Returns the errors encountered in the document.
+  std::vector<Reader::StructuredError> getStructuredErrors() const;
+  /// Return whether there are any errors.
+  bool good() const;
+
+private:
+  friend class LazyValue;
+  friend class LazyValue::const_iterator;
+
+  class Indexer;
+
+  /// An array or object of the document, in the order they start.
+  class Node {
+  public:
+    ValueType type_;
+    /// Number of elements or members, or unknownSize until they are found.
+    ArrayIndex size_;
+    size_t start_;
+    size_t limit_;
+    /// Index of the node following the nested nodes of this one.
+    size_t next_;
+    /// Index of the first element in elements_.
+    size_t elements_;
+  };
+
+  /// An element or member of a node that has been accessed.
+  class Element {
+  public:
+    size_t start_;
+    size_t limit_;
+    /// The member name as written, or an empty range for an array element.
+    size_t keyStart_;
+    size_t keyLimit_;
+    /// Index of the array or object in nodes_, or npos.
+    size_t node_;
+  };
+
+  typedef std::vector<Node> Nodes;
+  typedef std::vector<Element> Elements;
+  typedef std::map<size_t, Value> Values;
+
+  static const ArrayIndex unknownSize;
+  static const size_t npos;
+
+  LazyDocument(const LazyDocument&);
+  LazyDocument& operator=(const LazyDocument&);
+
+  void beginNode(ValueType type);
+  void endNode();
+  const Node& findElements(size_t node) const;
+  ValueType scalarType(size_t start, size_t limit) const;
+  std::string keyName(const Element& element) const;
+  bool keyEquals(const Element& element, const char* key, size_t length) const;
+  const Value& materialize(size_t start, size_t limit) const;
+
+  mutable Reader reader_;
+  std::string document_;
+  mutable Nodes nodes_;
+  std::vector<size_t> open_;
+  mutable Elements elements_;
+  Element root_;
+  bool parsed_;
+  mutable Values values_;
 };
 
 /** \brief Read from 'sin' into 'root'.
@@ -84,6 +84,56 @@ private:
   const char* str_;
 };
 
+/** \brief Stores one copy of each member name, shared by many objects.
+ *
+ * The objects of a large array of records usually repeat the same few member
+ * names. Instead of a copy of its name per member, the members named with an
+ * interned name all point at the single copy held by the table, like names
+ * given as StaticString, and lookups with the interned name find the member
+ * by comparing pointers before comparing characters.
+ *
+ * The names stay valid until the table is destroyed, which must therefore
+ * outlive the Values holding them, and their copies. A table is not
+ * thread-safe: use one per document, or per thread.
+ *
+ * Example of usage:
+ * \code
+ * Json::KeyTable keys;
+ * Json::Value record;
+ * record[Json::StaticString(keys.intern("id"))] = 1234;
+ * Json::Reader reader;
+ * reader.setKeyTable(&keys); // names read share the same copies
+ * \endcode
+ */
+class JSON_API KeyTable {
+public:
+  KeyTable();
+  ~KeyTable();
+
+  /// The interned copy of a '\0' terminated name.
+  const char* intern(const char* key);
+  /// The interned copy of the name [begin, end), which may contain '\0'
+  /// characters. The copy is '\0' terminated.
+  const char* intern(const char* begin, const char* end);
+  /// Number of distinct names interned.
+  size_t size() const;
+
+private:
+  KeyTable(const KeyTable&);
+  KeyTable& operator=(const KeyTable&);
+  void grow();
+
+  struct Key {
+    const char* string_;
+    unsigned length_;
+    unsigned hash_;
+  };
+
+  /// Open addressing hash table, of a power of two size.
+  std::vector<Key> keys_;
+  size_t size_;
+};
+
 /** \brief Represents a <a HREF="http://www.json.org">JSON</a> value.
  *
  * This class is a discriminated union wrapper that can represents a:
@@ -105,6 +155,12 @@ private:
  * if it does not exist.
  * The sequence of an #arrayValue will be automatically resize and initialized
  * with #nullValue. resize() can be used to enlarge or truncate an #arrayValue.
+ * The elements of an #arrayValue are stored contiguously: as for a std::vector,
+ * growing an array may move its elements, which invalidates the references
+ * and iterators to them.
+ * The members of an #objectValue are kept in a std::map, or with
+ * JSON_VALUE_USE_FLAT_MAP in a vector sorted by name, where adding or
+ * removing a member also invalidates the references to the other members.
  *
  * The get() methods can be used to obtanis default value in the case the
  *required element
@@ -115,6 +171,8 @@ private:
  */
 class JSON_API Value {
   friend class ValueIteratorBase;
+  friend class ReaderBase;
+  template <class Policy> friend class BasicReader;
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
   friend class ValueInternalLink;
   friend class ValueInternalMap;
@@ -168,7 +226,7 @@ private:
       duplicateOnCopy
     };
     CZString(ArrayIndex index);
-    CZString(const char* cstr, DuplicationPolicy allocate);
+    CZString(const char* cstr, unsigned length, DuplicationPolicy allocate);
     CZString(const CZString& other);
     ~CZString();
     CZString& operator=(CZString other);
@@ -176,20 +234,29 @@ private:
     bool operator==(const CZString& other) const;
     ArrayIndex index() const;
     const char* c_str() const;
+    /// Length of the string of a key, which may contain '\0' characters.
+    unsigned length() const;
     bool isStaticString() const;
+    /// Takes ownership of a string stored with noDuplication, which must have
+    /// been allocated by malloc().
+    void adopt();
+    void swap(CZString& other);
 
   private:
-    void swap(CZString& other);
     const char* cstr_;
     ArrayIndex index_;
+    unsigned length_;
   };
 
 public:
-#ifndef JSON_USE_CPPTL_SMALLMAP
+#if defined(JSON_VALUE_USE_FLAT_MAP)
+  class ObjectValues;
+#elif !defined(JSON_USE_CPPTL_SMALLMAP)
   typedef std::map<CZString, Value> ObjectValues;
 #else
   typedef CppTL::SmallMap<CZString, Value> ObjectValues;
 #endif // ifndef JSON_USE_CPPTL_SMALLMAP
+  typedef std::vector<Value> ArrayValues;
 #endif // ifndef JSON_VALUE_USE_INTERNAL_MAP
 #endif // ifndef JSONCPP_DOC_EXCLUDE_IMPLEMENTATION
 
@@ -257,7 +324,21 @@ Json::Value obj_value(Json::objectValue); // {}
   bool operator!=(const Value& other) const;
   int compare(const Value& other) const;
 
+  /// The string of a #stringValue. Strings shorter than 8 bytes are stored
+  /// in the Value itself: the pointer is then only valid until the Value is
+  /// modified or moved.
+  /// The string is terminated by a '\0', but may also contain some: see
+  /// getString().
   const char* asCString() const;
+  /** \brief Get the range of the string of a #stringValue, in constant time.
+   *
+   * Unlike asCString(), the range includes the '\0' characters the string
+   * may contain, as read from "\u0000" escapes or given to
+   * Value(const char*, const char*).
+   * \return \c false if the Value is not a string, or a string built by
+   *         Value(stringValue), which then has no range.
+   */
+  bool getString(const char** begin, const char** end) const;
   std::string asString() const;
 #ifdef JSON_USE_CPPTL
   CppTL::ConstString asConstString() const;
@@ -343,7 +424,7 @@ Json::Value obj_value(Json::objectValue); // {}
   Value get(ArrayIndex index, const Value& defaultValue) const;
   /// Return true if index < size().
   bool isValidIndex(ArrayIndex index) const;
-  /// \brief Append value to array at the end.
+  /// \brief Append value to array at the end, in amortized constant time.
   ///
   /// Equivalent to jsonvalue[jsonvalue.size()] = value;
   Value& append(const Value& value);
@@ -380,6 +461,13 @@ Json::Value obj_value(Json::objectValue); // {}
 #endif
   /// Return the member named key if it exist, defaultValue otherwise.
   Value get(const char* key, const Value& defaultValue) const;
+  /** \brief Find the member named [\a begin, \a end), which may contain '\0'
+   * characters.
+   *
+   * \return a pointer to the member, or 0 if there is none or this is not an
+   *         object.
+   */
+  const Value* find(const char* begin, const char* end) const;
   /// Return the member named key if it exist, defaultValue otherwise.
   Value get(const std::string& key, const Value& defaultValue) const;
 #ifdef JSON_USE_CPPTL
@@ -403,6 +491,9 @@ Json::Value obj_value(Json::objectValue); // {}
       \return true iff removed (no exceptions)
   */
   bool removeMember(const char* key, Value* removed);
+  /// Same as removeMember(const char*, Value*), for a key of
+  /// [begin, end) that may contain '\0' characters.
+  bool removeMember(const char* begin, const char* end, Value* removed);
   /** \brief Remove the indexed array element.
 
       O(n) expensive operations.
@@ -449,7 +540,8 @@ Json::Value obj_value(Json::objectValue); // {}
   iterator end();
 
   // Accessors for the [start, limit) range of bytes within the JSON text from
-  // which this value was parsed, if any.
+  // which this value was parsed, if any. Always 0 if the library is built with
+  // JSON_VALUE_NO_OFFSETS.
   void setOffsetStart(size_t start);
   void setOffsetLimit(size_t limit);
   size_t getOffsetStart() const;
@@ -457,8 +549,40 @@ Json::Value obj_value(Json::objectValue); // {}
 
 private:
   void initBasic(ValueType type, bool allocated = false);
-
-  Value& resolveReference(const char* key, bool isStatic);
+  void initString(const char* value, size_t length);
+  const char* storedString() const;
+
+  Value& resolveReference(const char* key, size_t length, bool isStatic);
+
+  // Used by the reader to store the strings it decodes without copying them:
+  // \a value and \a key must be allocated by malloc(), and are owned by the
+  // Value from then on. A string read in situ is referenced, and not owned.
+  void adoptString(char* value, size_t length);
+  Value& adoptMember(char* key, size_t length);
+  void referString(const char* value, size_t length);
+
+  // Used by the reader to update a tree in place: the buffer of an owned
+  // string of at least \a length characters, or 0 if there is none.
+  char* reusableString(size_t length);
+  // Used by the reader to decode short strings straight into the Value: makes
+  // it an empty string stored inline and returns its buffer of at least
+  // \a length characters, or 0 if \a length is too long to be stored inline.
+  char* inlineString(size_t length);
+  // Sets the length of the string decoded into the buffer of
+  // reusableString() or inlineString(), and terminates it.
+  void setStringLength(size_t length);
+  void dropComments();
+  // Returns the member named \a key, adding it if needed, and sets \a id to
+  // a pointer identifying it for as long as it is kept, even if the storage
+  // of the object moves it. A new member refers to a static \a key rather
+  // than copying it.
+  Value& resolveMember(const char* key,
+                       size_t length,
+                       bool isStatic,
+                       const void*& id);
+  // Removes the members of an object whose id is not in the sorted range
+  // [\a begin, \a end).
+  void retainMembers(const void* const* begin, const void* const* end);
 
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
   inline bool isItemAvailable() const { return itemIsUsed_ == 0; }
@@ -497,26 +621,75 @@ private:
     double real_;
     bool bool_;
     char* string_;
+    char chars_[sizeof(double)]; // a string shorter than 8 bytes, if inlined_
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
     ValueInternalArray* array_;
     ValueInternalMap* map_;
 #else
+    ArrayValues* array_;
     ObjectValues* map_;
 #endif
   } value_;
   ValueType type_ : 8;
   unsigned allocated_ : 1; // Notes: if declared as bool, bitfield is useless.
+  unsigned inlined_ : 1;
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
   unsigned int itemIsUsed_ : 1; // used by the ValueInternalMap container.
   int memberNameIsStatic_ : 1;  // used by the ValueInternalMap container.
 #endif
+  unsigned length_; // of a string, in the room the bit-fields leave
   CommentInfo* comments_;
 
+#ifndef JSON_VALUE_NO_OFFSETS
   // [start, limit) byte offsets in the source JSON text from which this Value
   // was extracted.
   size_t start_;
   size_t limit_;
+#endif
+};
+
+#if defined(JSON_VALUE_USE_FLAT_MAP) && !defined(JSON_VALUE_USE_INTERNAL_MAP)
+#ifndef JSONCPP_DOC_EXCLUDE_IMPLEMENTATION
+/** \brief Members of an #objectValue, stored in a vector sorted by name.
+ *
+ * Used instead of std::map when JSON_VALUE_USE_FLAT_MAP is defined: an
+ * object makes a single allocation for all its members instead of one per
+ * member, and finds them by binary search over contiguous memory. Members
+ * are ordered as in std::map, so iterating over an object and writing it
+ * give the same result with both. Adding or removing a member moves the
+ * members after it, by swapping them rather than copying their trees.
+ */
+class JSON_API Value::ObjectValues {
+public:
+  typedef std::pair<CZString, Value> value_type;
+  typedef std::vector<value_type>::iterator iterator;
+  typedef std::vector<value_type>::const_iterator const_iterator;
+
+  iterator begin() { return members_.begin(); }
+  iterator end() { return members_.end(); }
+  const_iterator begin() const { return members_.begin(); }
+  const_iterator end() const { return members_.end(); }
+  size_t size() const { return members_.size(); }
+  void clear() { members_.clear(); }
+
+  iterator lower_bound(const CZString& key);
+  iterator find(const CZString& key);
+  const_iterator find(const CZString& key) const;
+  /// Inserts \a member before \a position, which must keep the members
+  /// sorted.
+  iterator insert(iterator position, const value_type& member);
+  iterator erase(iterator position);
+
+  bool operator<(const ObjectValues& other) const;
+  bool operator==(const ObjectValues& other) const;
+
+private:
+  static bool isKeyLess(const value_type& member, const CZString& key);
+
+  std::vector<value_type> members_;
 };
+#endif // ifndef JSONCPP_DOC_EXCLUDE_IMPLEMENTATION
+#endif // if defined(JSON_VALUE_USE_FLAT_MAP) && ...
 
 /** \brief Experimental and untested: represents an element of the "path" to
  * access a node.
@@ -524,6 +697,7 @@ private:
 class JSON_API PathArgument {
 public:
   friend class Path;
+  template <class Policy> friend class BasicReader;
 
   PathArgument();
   PathArgument(ArrayIndex index);
@@ -568,6 +742,8 @@ public:
   Value& make(Value& root) const;
 
 private:
+  template <class Policy> friend class BasicReader;
+
   typedef std::vector<const PathArgument*> InArgs;
   typedef std::vector<PathArgument> Args;
 
@@ -933,6 +1109,8 @@ public:
   ValueIteratorBase();
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   explicit ValueIteratorBase(const Value::ObjectValues::iterator& current);
+  ValueIteratorBase(const Value::ArrayValues::iterator& current,
+                    ArrayIndex index);
 #else
   ValueIteratorBase(const ValueInternalArray::IteratorState& state);
   ValueIteratorBase(const ValueInternalMap::IteratorState& state);
@@ -943,7 +1121,7 @@ public:
   bool operator!=(const SelfType& other) const { return !isEqual(other); }
 
   difference_type operator-(const SelfType& other) const {
-    return computeDistance(other);
+    return other.computeDistance(*this);
   }
 
   /// Return either the index or the member name of the referenced value as a
@@ -956,6 +1134,9 @@ public:
   /// Return the member name of the referenced Value. "" if it is not an
   /// objectValue.
   const char* memberName() const;
+  /// Return the member name of the referenced Value, which may contain '\0'
+  /// characters, and set \a end to its end. "" if it is not an objectValue.
+  const char* memberName(const char** end) const;
 
 protected:
   Value& deref() const;
@@ -973,8 +1154,12 @@ protected:
 private:
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   Value::ObjectValues::iterator current_;
+  // Element and index of the element, if the iterator is for an arrayValue.
+  Value::ArrayValues::iterator element_;
+  ArrayIndex index_;
   // Indicates that iterator is for a null value.
   bool isNull_;
+  bool isArray_;
 #else
   union {
     ValueInternalArray::IteratorState array_;
@@ -1005,6 +1190,8 @@ private:
  */
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   explicit ValueConstIterator(const Value::ObjectValues::iterator& current);
+  ValueConstIterator(const Value::ArrayValues::iterator& current,
+                     ArrayIndex index);
 #else
   ValueConstIterator(const ValueInternalArray::IteratorState& state);
   ValueConstIterator(const ValueInternalMap::IteratorState& state);
@@ -1061,6 +1248,7 @@ private:
  */
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   explicit ValueIterator(const Value::ObjectValues::iterator& current);
+  ValueIterator(const Value::ArrayValues::iterator& current, ArrayIndex index);
 #else
   ValueIterator(const ValueInternalArray::IteratorState& state);
   ValueIterator(const ValueInternalMap::IteratorState& state);
@@ -0,0 +1,95 @@
+// Copyright 2007-2010 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+/* Times the building, parsing and traversal of large arrays shaped like
+ * test/data/test_large_01.json: an outer array of rows, each holding a
+ * string followed by a long run of integers.
+ */
+
+#include <json/json.h>
+#include <ctime>
+#include <stdio.h>
+
+static const int rows = 100;
+static const int columns = 1000;
+static const int iterations = 20;
+
+static std::string makeDocument() {
+  std::string document = "[";
+  for (int row = 0; row < rows; ++row) {
+    document += row ? ",[\"A\"" : "[\"A\"";
+    for (int column = 0; column < columns; ++column) {
+      char buffer[16];
+      snprintf(buffer, sizeof(buffer), ",%d", column);
+      document += buffer;
+    }
+    document += "]";
+  }
+  return document + "]";
+}
+
+static void report(const char* name, clock_t start) {
+  const double seconds = double(clock() - start) / CLOCKS_PER_SEC;
+  printf("%-24s %10.2f ms/iteration\n", name, seconds * 1e3 / iterations);
+}
+
+int main() {
+  const std::string document = makeDocument();
+  printf("document: %u bytes, %d x %d elements, %d iterations\n",
+         unsigned(document.size()),
+         rows,
+         columns + 1,
+         iterations);
+
+  clock_t start = clock();
+  for (int index = 0; index < iterations; ++index) {
+    Json::Value root(Json::arrayValue);
+    for (int row = 0; row < rows; ++row) {
+      Json::Value& line = root.append(Json::Value(Json::arrayValue));
+      line.append("A");
+      for (int column = 0; column < columns; ++column)
+        line.append(column);
+    }
+  }
+  report("append", start);
+
+  Json::Reader reader;
+  Json::Value root;
+  start = clock();
+  for (int index = 0; index < iterations; ++index) {
+    Json::Value parsed;
+    if (!reader.parse(document, parsed))
+      return 1;
+    root.swap(parsed);
+  }
+  report("parse", start);
+
+  const Json::Value& table = root;
+  Json::LargestInt sum = 0;
+  start = clock();
+  for (int index = 0; index < iterations; ++index) {
+    for (Json::Value::const_iterator row = table.begin(); row != table.end();
+         ++row) {
+      const Json::Value& line = *row;
+      for (Json::Value::const_iterator it = line.begin(); it != line.end();
+           ++it) {
+        if ((*it).isInt())
+          sum += (*it).asLargestInt();
+      }
+    }
+  }
+  report("iterate", start);
+
+  start = clock();
+  for (int index = 0; index < iterations; ++index) {
+    for (Json::ArrayIndex row = 0; row < table.size(); ++row) {
+      const Json::Value& line = table[row];
+      for (Json::ArrayIndex column = 1; column < line.size(); ++column)
+        sum += line[column].asLargestInt();
+    }
+  }
+  report("index", start);
+  return sum == 0;
+}
@@ -0,0 +1,109 @@
+// Copyright 2007-2010 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+/* Measures the memory taken by a large array of records that all have the
+ * same member names, read with each member owning a copy of its name, or
+ * with the names shared through a KeyTable:
+ *   jsoncpp_key_interning [records]          names copied
+ *   jsoncpp_key_interning [records] shared   names shared
+ * The memory is the growth of the peak resident set size during the parse,
+ * so each way is measured by a process of its own.
+ */
+
+#include <json/json.h>
+#include <ctime>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+static const char* const names[] = { "id",      "name",     "email",
+                                     "active",  "score",    "country",
+                                     "created", "modified", "parent",
+                                     "tags" };
+static const int nameCount = sizeof(names) / sizeof(*names);
+
+static std::string makeDocument(int records) {
+  std::string document;
+  document.reserve(size_t(records) * 200);
+  document += "[";
+  for (int record = 0; record < records; ++record) {
+    char buffer[256];
+    snprintf(buffer,
+             sizeof(buffer),
+             "%s{\"id\":%d,\"name\":\"user%d\","
+             "\"email\":\"user%d@example.com\","
+             "\"active\":%s,\"score\":%d.5,\"country\":\"FR\","
+             "\"created\":%d,\"modified\":%d,\"parent\":null,"
+             "\"tags\":[\"a\",\"b\"]}",
+             record ? "," : "",
+             record,
+             record,
+             record,
+             record % 2 ? "true" : "false",
+             record % 100,
+             1400000000 + record,
+             1400000000 + 2 * record);
+    document += buffer;
+  }
+  return document + "]";
+}
+
+// Peak resident set size of the process, in kilobytes, or 0 if unknown.
+static long peakMemory() {
+#if !defined(_WIN32)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+    return usage.ru_maxrss;
+#endif
+  return 0;
+}
+
+int main(int argc, const char* argv[]) {
+  const int records = argc > 1 ? atoi(argv[1]) : 1000000;
+  const bool shared = argc > 2 && strcmp(argv[2], "shared") == 0;
+  const std::string document = makeDocument(records);
+  printf("document: %u bytes, %d records of %d members, names %s\n",
+         unsigned(document.size()),
+         records,
+         nameCount,
+         shared ? "shared" : "copied");
+
+  Json::KeyTable keys;
+  Json::Reader reader;
+  if (shared)
+    reader.setKeyTable(&keys);
+  Json::Value root;
+  const long before = peakMemory();
+  clock_t start = clock();
+  if (!reader.parse(
+          document.data(), document.data() + document.size(), root, false))
+    return 1;
+  const double parseSeconds = double(clock() - start) / CLOCKS_PER_SEC;
+  const long after = peakMemory();
+  printf("parse:  %10.2f ms\n", parseSeconds * 1e3);
+  printf("memory: %10ld kB, %.1f bytes/record\n",
+         after - before,
+         (after - before) * 1024.0 / records);
+
+  // Looks every member up by a name interned in the table, or by a copy.
+  const char* keyNames[nameCount];
+  for (int index = 0; index < nameCount; ++index)
+    keyNames[index] = shared ? keys.intern(names[index]) : names[index];
+  size_t found = 0;
+  start = clock();
+  for (Json::ArrayIndex record = 0; record < root.size(); ++record) {
+    const Json::Value& value = root[record];
+    for (int index = 0; index < nameCount; ++index) {
+      const char* name = keyNames[index];
+      found += value.find(name, name + strlen(name)) != 0;
+    }
+  }
+  const double lookupSeconds = double(clock() - start) / CLOCKS_PER_SEC;
+  printf("lookup: %10.2f ms\n", lookupSeconds * 1e3);
+  return found == size_t(records) * nameCount ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+// Copyright 2007-2010 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+/* Counts the memory allocations made to parse the same small document many
+ * times, with a new Reader for each document or with a single reused Reader,
+ * into a new Value or into the same one with parseInto().
+ * The allocations of the reader itself are the difference between a parse
+ * building a Value and a parse reporting to a ReaderHandler, which allocates
+ * nothing once the buffers of the reader have grown.
+ */
+
+#include <json/json.h>
+#include <ctime>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if __cplusplus >= 201103L
+#define JSONCPP_BENCHMARK_THROW_BAD_ALLOC
+#define JSONCPP_BENCHMARK_NOTHROW noexcept
+#else
+#define JSONCPP_BENCHMARK_THROW_BAD_ALLOC throw(std::bad_alloc)
+#define JSONCPP_BENCHMARK_NOTHROW throw()
+#endif
+
+static unsigned long allocations = 0;
+
+void* operator new(size_t size) JSONCPP_BENCHMARK_THROW_BAD_ALLOC {
+  ++allocations;
+  if (void* p = malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) JSONCPP_BENCHMARK_THROW_BAD_ALLOC {
+  return operator new(size);
+}
+
+void operator delete(void* p) JSONCPP_BENCHMARK_NOTHROW { free(p); }
+
+void operator delete[](void* p) JSONCPP_BENCHMARK_NOTHROW { free(p); }
+
+static std::string makeDocument() {
+  std::string document = "{ \"jsonrpc\": \"2.0\", \"id\": 8127, "
+                         "\"method\": \"inventory.update\", \"params\": [";
+  for (int index = 0; index < 12; ++index) {
+    if (index)
+      document += ", ";
+    document += "{ \"sku\": \"AB-1029-X\", \"quantity\": 12, "
+                "\"price\": 19.95, \"tags\": [\"new\", \"sale\"], "
+                "\"note\": \"ships in \\\"2\\\" days\\n\", \"active\": true }";
+  }
+  return document + "] }";
+}
+
+static const int iterations = 20000;
+
+static void report(const char* name, unsigned long count, clock_t start) {
+  const double seconds = double(clock() - start) / CLOCKS_PER_SEC;
+  printf("%-32s %8.2f allocations/parse %8.2f us/parse\n",
+         name,
+         double(count) / iterations,
+         seconds * 1e6 / iterations);
+}
+
+int main() {
+  const std::string document = makeDocument();
+  const char* begin = document.data();
+  const char* end = begin + document.size();
+  printf("document: %u bytes, %d parses\n",
+         unsigned(document.size()),
+         iterations);
+
+  clock_t start = clock();
+  unsigned long count = allocations;
+  for (int index = 0; index < iterations; ++index) {
+    Json::Reader reader;
+    Json::Value root;
+    if (!reader.parse(document, root))
+      return 1;
+  }
+  report("new reader, Value", allocations - count, start);
+
+  Json::Reader reader;
+  Json::Value root;
+  reader.parse(document, root); // grows the buffers of the reader
+  start = clock();
+  count = allocations;
+  for (int index = 0; index < iterations; ++index) {
+    Json::Value root;
+    if (!reader.parse(document, root))
+      return 1;
+  }
+  report("reused reader, Value", allocations - count, start);
+
+  start = clock();
+  count = allocations;
+  for (int index = 0; index < iterations; ++index) {
+    if (!reader.parseInto(document, root))
+      return 1;
+  }
+  report("reused reader, parseInto", allocations - count, start);
+
+  Json::ReaderHandler handler;
+  start = clock();
+  count = allocations;
+  for (int index = 0; index < iterations; ++index) {
+    if (!reader.parse(begin, end, handler))
+      return 1;
+  }
+  report("reused reader, ReaderHandler", allocations - count, start);
+
+  start = clock();
+  count = allocations;
+  for (int index = 0; index < iterations; ++index) {
+    Json::Reader reader;
+    if (!reader.parse(begin, end, handler))
+      return 1;
+  }
+  report("new reader, ReaderHandler", allocations - count, start);
+  return 0;
+}
@@ -144,7 +144,10 @@ static int parseAndSaveValueTree(const std::string& input,
                                  Json::Value* root)
 {
   Json::Reader reader(features);
-  bool parsingSuccessful = reader.parse(input, *root);
+  const char* begin = input.data();
+  bool parsingSuccessful = parseOnly
+                               ? reader.validate(begin, begin + input.size())
+                               : reader.parse(input, *root);
   if (!parsingSuccessful) {
     printf("Failed to parse %s file: \n%s\n",
            kind.c_str(),
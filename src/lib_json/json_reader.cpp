@@ -8,17 +8,66 @@
 #include <json/reader.h>
 #include <json/value.h>
 #include "json_tool.h"
+#include "json_doubleparser.h"
 #endif // if !defined(JSON_IS_AMALGAMATION)
+#include <algorithm>
 #include <utility>
 #include <cstdio>
 #include <cassert>
 #include <cstring>
+#include <cstdlib>
+#include <deque>
 #include <istream>
+#include <limits>
 
 #if defined(_MSC_VER) && _MSC_VER < 1500 // VC++ 8.0 and below
 #define snprintf _snprintf
 #endif
 
+// LinesReader parses on several threads when the standard library has them.
+#if !defined(JSONCPP_NO_THREADS) &&                                            \
+    (__cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1700))
+#define JSONCPP_HAS_THREADS 1
+#include <atomic>
+#include <thread>
+#endif
+
+#if defined(_WIN32)
+// Used by MappedDocument.
+#define WIN32_LEAN_AND_MEAN
+#if !defined(NOMINMAX)
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Vectorized scanning of whitespace runs and string bodies. AVX2 and SSSE3,
+// which the UTF-8 validation needs for its table lookups, are only used when
+// the compiler targets them, SSE2 is part of every x86-64 target, and any
+// other architecture gets the scalar loops.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define JSONCPP_SCAN_AVX2 1
+#define JSONCPP_SCAN_SSSE3 1
+#define JSONCPP_SCAN_SSE2 1
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define JSONCPP_SCAN_SSSE3 1
+#define JSONCPP_SCAN_SSE2 1
+#elif defined(__SSE2__) || defined(_M_X64) ||                                  \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JSONCPP_SCAN_SSE2 1
+#endif
+#if defined(JSONCPP_SCAN_SSE2) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace Json {
 
 // Implementation of class Features
@@ -26,7 +75,8 @@ namespace Json {
 
 Features::Features()
     : allowComments_(true), strictRoot_(false),
-      allowDroppedNullPlaceholders_(true), allowNumericKeys_(true) {}
+      allowDroppedNullPlaceholders_(true), allowNumericKeys_(true),
+      maxDepth_(1000), allowInvalidUTF8_(true), storeOffsets_(true) {}
 
 Features Features::all() { return Features(); }
 
@@ -65,28 +115,552 @@ static std::string::iterator normalizeEOL(std::string::iterator begin,
   return normalized;
 }
 
-// Class Reader
+#if defined(JSONCPP_SCAN_SSE2)
+/// Returns the index of the lowest set bit of a non-zero mask.
+static inline unsigned lowestBitIndex(unsigned mask) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return static_cast<unsigned>(index);
+#else
+  return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+#endif // if defined(JSONCPP_SCAN_SSE2)
+
+/** Skips the run of whitespace starting at \a current.
+ * \param linebreak Set to \c true if the run contains a '\\r' or '\\n'.
+ * \return Location of the first non-whitespace character, or \a end.
+ */
+static Reader::Location skipWhitespace(Reader::Location current,
+                                       Reader::Location end,
+                                       bool& linebreak) {
+  // Most runs between tokens are empty or a single character, so look at the
+  // first two characters before paying for a vector load.
+  for (int index = 0; index < 2; ++index, ++current) {
+    if (current == end)
+      return current;
+    Reader::Char c = *current;
+    if (c == '\r' || c == '\n')
+      linebreak = true;
+    else if (c != ' ' && c != '\t')
+      return current;
+  }
+#if defined(JSONCPP_SCAN_AVX2)
+  const __m256i space32 = _mm256_set1_epi8(' ');
+  const __m256i tab32 = _mm256_set1_epi8('\t');
+  const __m256i cr32 = _mm256_set1_epi8('\r');
+  const __m256i lf32 = _mm256_set1_epi8('\n');
+  while (end - current >= 32) {
+    __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current));
+    __m256i eol = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, cr32),
+                                  _mm256_cmpeq_epi8(chunk, lf32));
+    __m256i blank = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, space32),
+                                    _mm256_cmpeq_epi8(chunk, tab32));
+    unsigned eolMask = static_cast<unsigned>(_mm256_movemask_epi8(eol));
+    unsigned otherMask = ~static_cast<unsigned>(
+        _mm256_movemask_epi8(_mm256_or_si256(eol, blank)));
+    if (otherMask) {
+      unsigned index = lowestBitIndex(otherMask);
+      if (eolMask & ((1u << index) - 1))
+        linebreak = true;
+      return current + index;
+    }
+    if (eolMask)
+      linebreak = true;
+    current += 32;
+  }
+#endif // if defined(JSONCPP_SCAN_AVX2)
+#if defined(JSONCPP_SCAN_SSE2)
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+  while (end - current >= 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current));
+    __m128i eol =
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, cr), _mm_cmpeq_epi8(chunk, lf));
+    __m128i blank =
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab));
+    unsigned eolMask = static_cast<unsigned>(_mm_movemask_epi8(eol));
+    unsigned otherMask =
+        ~static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(eol, blank))) &
+        0xFFFF;
+    if (otherMask) {
+      unsigned index = lowestBitIndex(otherMask);
+      if (eolMask & ((1u << index) - 1))
+        linebreak = true;
+      return current + index;
+    }
+    if (eolMask)
+      linebreak = true;
+    current += 16;
+  }
+#endif // if defined(JSONCPP_SCAN_SSE2)
+  for (; current != end; ++current) {
+    Reader::Char c = *current;
+    if (c == '\r' || c == '\n')
+      linebreak = true;
+    else if (c != ' ' && c != '\t')
+      break;
+  }
+  return current;
+}
+
+/** Finds the next character that ends a run of plain string content.
+ * \return Location of the first '"', '\\' or NUL character at or after
+ *         \a current, or \a end if there is none.
+ */
+static Reader::Location scanStringContent(Reader::Location current,
+                                          Reader::Location end) {
+#if defined(JSONCPP_SCAN_AVX2)
+  const __m256i quote32 = _mm256_set1_epi8('"');
+  const __m256i backslash32 = _mm256_set1_epi8('\\');
+  const __m256i zero32 = _mm256_setzero_si256();
+  while (end - current >= 32) {
+    __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current));
+    __m256i special = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote32),
+                        _mm256_cmpeq_epi8(chunk, backslash32)),
+        _mm256_cmpeq_epi8(chunk, zero32));
+    unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(special));
+    if (mask)
+      return current + lowestBitIndex(mask);
+    current += 32;
+  }
+#endif // if defined(JSONCPP_SCAN_AVX2)
+#if defined(JSONCPP_SCAN_SSE2)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i zero = _mm_setzero_si128();
+  while (end - current >= 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current));
+    __m128i special =
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                  _mm_cmpeq_epi8(chunk, backslash)),
+                     _mm_cmpeq_epi8(chunk, zero));
+    unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+    if (mask)
+      return current + lowestBitIndex(mask);
+    current += 16;
+  }
+#endif // if defined(JSONCPP_SCAN_SSE2)
+  for (; current != end; ++current) {
+    Reader::Char c = *current;
+    if (c == '"' || c == '\\' || c == '\0')
+      break;
+  }
+  return current;
+}
+
+/** Finds the first invalid UTF-8 sequence in [\a current, \a end): a byte
+ * that is not a valid lead, a truncated sequence, an overlong form, a
+ * surrogate or a code point above U+10FFFF.
+ * \return Location of the first byte of the invalid sequence, or \a end.
+ */
+static Reader::Location findInvalidUTF8(Reader::Location current,
+                                        Reader::Location end) {
+  while (current != end) {
+#if defined(JSONCPP_SCAN_SSE2)
+    if (end - current >= 16) {
+      __m128i chunk =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(current));
+      unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(chunk));
+      if (mask == 0) {
+        current += 16;
+        continue;
+      }
+      current += lowestBitIndex(mask);
+    }
+#endif // if defined(JSONCPP_SCAN_SSE2)
+    const unsigned lead = static_cast<unsigned char>(*current);
+    if (lead < 0x80) {
+      ++current;
+      continue;
+    }
+    int length;
+    unsigned codepoint;
+    unsigned minimum;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+      length = 2;
+      codepoint = lead & 0x1F;
+      minimum = 0x80;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+      length = 3;
+      codepoint = lead & 0x0F;
+      minimum = 0x800;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+      length = 4;
+      codepoint = lead & 0x07;
+      minimum = 0x10000;
+    } else {
+      return current;
+    }
+    if (end - current < length)
+      return current;
+    for (int index = 1; index < length; ++index) {
+      const unsigned c = static_cast<unsigned char>(current[index]);
+      if ((c & 0xC0) != 0x80)
+        return current;
+      codepoint = (codepoint << 6) | (c & 0x3F);
+    }
+    if (codepoint < minimum || codepoint > 0x10FFFF ||
+        (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+      return current;
+    current += length;
+  }
+  return end;
+}
+
+#if defined(JSONCPP_SCAN_SSSE3)
+// UTF-8 validation by table lookups, from Keiser and Lemire, "Validating
+// UTF-8 In Less Than One Instruction Per Byte". Each pair of consecutive bytes
+// is classified by three lookups, on the high and low nibbles of the first
+// byte and the high nibble of the second one, each returning the set of
+// errors the nibble allows; an error is found when all three allow it.
+enum {
+  utf8TooShort = 1 << 0,     // 11______ followed by 0_______ or 11______
+  utf8TooLong = 1 << 1,      // 0_______ followed by 10______
+  utf8Overlong3 = 1 << 2,    // 11100000 100_____
+  utf8TooLarge = 1 << 3,     // 11110100 1001____ and above
+  utf8Surrogate = 1 << 4,    // 11101101 101_____
+  utf8Overlong2 = 1 << 5,    // 1100000_ 10______
+  utf8TooLarge1000 = 1 << 6, // 11110101 1000____ and above
+  utf8Overlong4 = 1 << 6,    // 11110000 1000____
+  utf8TwoConts = 1 << 7,     // 10______ 10______
+  utf8Carry = utf8TooShort | utf8TooLong | utf8TwoConts
+};
+
+static const unsigned char utf8Byte1High[16] = {
+  utf8TooLong, utf8TooLong, utf8TooLong, utf8TooLong,
+  utf8TooLong, utf8TooLong, utf8TooLong, utf8TooLong,
+  utf8TwoConts, utf8TwoConts, utf8TwoConts, utf8TwoConts,
+  utf8TooShort | utf8Overlong2,
+  utf8TooShort,
+  utf8TooShort | utf8Overlong3 | utf8Surrogate,
+  utf8TooShort | utf8TooLarge | utf8TooLarge1000 | utf8Overlong4
+};
+
+static const unsigned char utf8Byte1Low[16] = {
+  utf8Carry | utf8Overlong3 | utf8Overlong2 | utf8Overlong4,
+  utf8Carry | utf8Overlong2,
+  utf8Carry,
+  utf8Carry,
+  utf8Carry | utf8TooLarge,
+  utf8Carry | utf8TooLarge | utf8TooLarge1000,
+  utf8Carry | utf8TooLarge | utf8TooLarge1000,
+  utf8Carry | utf8TooLarge | utf8TooLarge1000,
+  utf8Carry | utf8TooLarge | utf8TooLarge1000,
+  utf8Carry | utf8TooLarge | utf8TooLarge1000,
+  utf8Carry | utf8TooLarge | utf8TooLarge1000,
+  utf8Carry | utf8TooLarge | utf8TooLarge1000,
+  utf8Carry | utf8TooLarge | utf8TooLarge1000,
+  utf8Carry | utf8TooLarge | utf8TooLarge1000 | utf8Surrogate,
+  utf8Carry | utf8TooLarge | utf8TooLarge1000,
+  utf8Carry | utf8TooLarge | utf8TooLarge1000
+};
+
+static const unsigned char utf8Byte2High[16] = {
+  utf8TooShort, utf8TooShort, utf8TooShort, utf8TooShort,
+  utf8TooShort, utf8TooShort, utf8TooShort, utf8TooShort,
+  utf8TooLong | utf8Overlong2 | utf8TwoConts | utf8Overlong3 |
+      utf8TooLarge1000 | utf8Overlong4,
+  utf8TooLong | utf8Overlong2 | utf8TwoConts | utf8Overlong3 | utf8TooLarge,
+  utf8TooLong | utf8Overlong2 | utf8TwoConts | utf8Surrogate | utf8TooLarge,
+  utf8TooLong | utf8Overlong2 | utf8TwoConts | utf8Surrogate | utf8TooLarge,
+  utf8TooShort, utf8TooShort, utf8TooShort, utf8TooShort
+};
+
+// Largest value of the last three bytes of a block that do not start a
+// sequence continued in the next block.
+static const unsigned char utf8BlockEnd[16] = {
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xEF, 0xDF, 0xBF
+};
+
+static inline __m128i loadTable(const unsigned char* table) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(table));
+}
+
+/// Returns non-zero bytes where \a input, following \a previous, is invalid.
+static inline __m128i utf8Errors(__m128i input, __m128i previous) {
+  const __m128i nibble = _mm_set1_epi8(0x0F);
+  const __m128i prev1 = _mm_alignr_epi8(input, previous, 15);
+  const __m128i byte1High =
+      _mm_shuffle_epi8(loadTable(utf8Byte1High),
+                       _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+  const __m128i byte1Low =
+      _mm_shuffle_epi8(loadTable(utf8Byte1Low), _mm_and_si128(prev1, nibble));
+  const __m128i byte2High =
+      _mm_shuffle_epi8(loadTable(utf8Byte2High),
+                       _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+  const __m128i special =
+      _mm_and_si128(_mm_and_si128(byte1High, byte1Low), byte2High);
+  // The second and third continuation bytes of the 3 and 4 byte sequences are
+  // flagged as utf8TwoConts, and must be exactly those.
+  const __m128i prev2 = _mm_alignr_epi8(input, previous, 14);
+  const __m128i prev3 = _mm_alignr_epi8(input, previous, 13);
+  const __m128i third = _mm_subs_epu8(prev2, _mm_set1_epi8(0xE0 - 0x80));
+  const __m128i fourth = _mm_subs_epu8(prev3, _mm_set1_epi8(0xF0 - 0x80));
+  const __m128i continuation = _mm_and_si128(
+      _mm_or_si128(third, fourth), _mm_set1_epi8(static_cast<char>(0x80)));
+  return _mm_xor_si128(continuation, special);
+}
+#endif // if defined(JSONCPP_SCAN_SSSE3)
+
+/// Returns \c true if [\a current, \a end) is valid UTF-8.
+static bool isValidUTF8(Reader::Location current, Reader::Location end) {
+#if defined(JSONCPP_SCAN_SSSE3)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i blockEnd = loadTable(utf8BlockEnd);
+  __m128i previous = zero;
+  __m128i incomplete = zero;
+  __m128i error = zero;
+  for (;;) {
+    __m128i input;
+    const bool last = end - current < 16;
+    if (last) {
+      // Pad the end with NUL characters, which end any sequence.
+      char block[16] = {0};
+      std::memcpy(block, current, end - current);
+      input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+    } else {
+      input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current));
+      current += 16;
+    }
+    if (_mm_movemask_epi8(input) == 0) {
+      error = _mm_or_si128(error, incomplete);
+      incomplete = zero;
+    } else {
+      error = _mm_or_si128(error, utf8Errors(input, previous));
+      incomplete = _mm_subs_epu8(input, blockEnd);
+    }
+    if (last)
+      break;
+    previous = input;
+  }
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(error, zero)) == 0xFFFF;
+#else  // if defined(JSONCPP_SCAN_SSSE3)
+  return findInvalidUTF8(current, end) == end;
+#endif // if defined(JSONCPP_SCAN_SSSE3)
+}
+
+#if defined(JSON_HAS_INT64)
+/// Loads 8 characters as a little-endian integer, whatever the byte order.
+static inline UInt64 loadEightChars(Reader::Location current) {
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(current);
+  UInt64 chars = 0;
+  for (int index = 7; index >= 0; --index)
+    chars = (chars << 8) | bytes[index];
+  return chars;
+}
+
+/// Returns true if the 8 loaded characters are all ASCII digits.
+static inline bool isEightDigits(UInt64 chars) {
+  // Adding 6 carries into the high nibble of any byte above '9'.
+  return ((chars & 0xF0F0F0F0F0F0F0F0ULL) |
+          (((chars + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+         0x3333333333333333ULL;
+}
+
+/// Converts 8 loaded ASCII digits to their value: pairs of digits, then
+/// groups of 4, then the 8 digits are combined by 3 multiplications.
+static inline UInt64 parseEightDigits(UInt64 chars) {
+  chars = ((chars & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+  chars = ((chars & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+  return ((chars & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+}
+#endif // if defined(JSON_HAS_INT64)
+
+// Class ReaderHandler
 // //////////////////////////////////////////////////////////////////
 
-Reader::Reader()
-    : errors_(), document_(), begin_(), end_(), current_(), lastValueEnd_(),
-      lastValue_(), commentsBefore_(), features_(Features::all()),
-      collectComments_() {}
+ReaderHandler::~ReaderHandler() {}
 
-Reader::Reader(const Features& features)
-    : errors_(), document_(), begin_(), end_(), current_(), lastValueEnd_(),
-      lastValue_(), commentsBefore_(), features_(features), collectComments_() {
+bool ReaderHandler::null() { return true; }
+
+bool ReaderHandler::boolean(bool) { return true; }
+
+bool ReaderHandler::integer(LargestInt) { return true; }
+
+bool ReaderHandler::unsignedInteger(LargestUInt) { return true; }
+
+bool ReaderHandler::real(double) { return true; }
+
+bool ReaderHandler::string(const char*, const char*) { return true; }
+
+bool ReaderHandler::startObject() { return true; }
+
+bool ReaderHandler::key(const char*, const char*) { return true; }
+
+bool ReaderHandler::endObject() { return true; }
+
+bool ReaderHandler::startArray() { return true; }
+
+bool ReaderHandler::endArray() { return true; }
+
+// Class MappedDocument
+// //////////////////////////////////////////////////////////////////
+
+class MappedDocument::Mapping {
+public:
+  Mapping(const char* begin, size_t size)
+      : begin_(begin), size_(size), count_(1) {}
+  ~Mapping() {
+    if (size_ == 0)
+      return; // empty files are not mapped
+#if defined(_WIN32)
+    UnmapViewOfFile(begin_);
+#else
+    munmap(const_cast<char*>(begin_), size_);
+#endif
+  }
+
+  static Mapping* map(const std::string& path);
+
+  const char* begin_;
+  size_t size_;
+#if defined(JSONCPP_HAS_THREADS)
+  // Copies may be made and closed on different threads.
+  std::atomic<unsigned> count_;
+#else
+  unsigned count_;
+#endif
+};
+
+MappedDocument::Mapping* MappedDocument::Mapping::map(const std::string& path) {
+#if defined(_WIN32)
+  HANDLE file = CreateFileA(path.c_str(),
+                            GENERIC_READ,
+                            FILE_SHARE_READ,
+                            0,
+                            OPEN_EXISTING,
+                            FILE_FLAG_SEQUENTIAL_SCAN,
+                            0);
+  if (file == INVALID_HANDLE_VALUE)
+    return 0;
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize) ||
+      static_cast<unsigned long long>(fileSize.QuadPart) >
+          static_cast<size_t>(-1)) {
+    CloseHandle(file);
+    return 0;
+  }
+  size_t size = static_cast<size_t>(fileSize.QuadPart);
+  if (size == 0) {
+    CloseHandle(file);
+    return new Mapping("", 0);
+  }
+  HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+  CloseHandle(file);
+  if (!mapping)
+    return 0;
+  void* begin = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (!begin)
+    return 0;
+#else
+  int file = ::open(path.c_str(), O_RDONLY);
+  if (file < 0)
+    return 0;
+  struct stat status;
+  if (fstat(file, &status) != 0 || !S_ISREG(status.st_mode) ||
+      static_cast<unsigned long long>(status.st_size) >
+          static_cast<size_t>(-1)) {
+    ::close(file);
+    return 0;
+  }
+  size_t size = static_cast<size_t>(status.st_size);
+  if (size == 0) {
+    ::close(file);
+    return new Mapping("", 0);
+  }
+  void* begin = mmap(0, size, PROT_READ, MAP_PRIVATE, file, 0);
+  ::close(file);
+  if (begin == MAP_FAILED)
+    return 0;
+#if defined(MADV_SEQUENTIAL)
+  madvise(begin, size, MADV_SEQUENTIAL);
+#endif
+#endif
+  return new Mapping(static_cast<const char*>(begin), size);
+}
+
+MappedDocument::MappedDocument() : mapping_(0) {}
+
+MappedDocument::MappedDocument(const MappedDocument& other)
+    : mapping_(other.mapping_) {
+  if (mapping_)
+    ++mapping_->count_;
+}
+
+MappedDocument& MappedDocument::operator=(const MappedDocument& other) {
+  if (other.mapping_)
+    ++other.mapping_->count_;
+  close();
+  mapping_ = other.mapping_;
+  return *this;
+}
+
+MappedDocument::~MappedDocument() { close(); }
+
+bool MappedDocument::open(const std::string& path) {
+  close();
+  mapping_ = Mapping::map(path);
+  return mapping_ != 0;
+}
+
+void MappedDocument::close() {
+  if (mapping_ && --mapping_->count_ == 0)
+    delete mapping_;
+  mapping_ = 0;
+}
+
+bool MappedDocument::isOpen() const { return mapping_ != 0; }
+
+const char* MappedDocument::begin() const {
+  return mapping_ ? mapping_->begin_ : 0;
+}
+
+const char* MappedDocument::end() const {
+  return mapping_ ? mapping_->begin_ + mapping_->size_ : 0;
+}
+
+size_t MappedDocument::size() const { return mapping_ ? mapping_->size_ : 0; }
+
+// Class ReaderBase
+// //////////////////////////////////////////////////////////////////
+
+ReaderBase::ReaderBase()
+    : errors_(), document_(), mappedDocument_(), begin_(), end_(), current_(),
+      lastValueEnd_(), lastValue_(), commentsBefore_(), collectComments_(),
+      inSitu_(false), reuse_(false), validateUTF8_(false), stringBuffer_() {}
+
+// Class BasicReader
+// //////////////////////////////////////////////////////////////////
+
+template <class Policy>
+BasicReader<Policy>::BasicReader(const Policy& policy)
+    : policy_(policy), keyTable_(0) {
+  validateUTF8_ = !policy_.allowInvalidUTF8();
 }
 
-bool
-Reader::parse(const std::string& document, Value& root, bool collectComments) {
+template <class Policy>
+bool BasicReader<Policy>::parse(const std::string& document,
+                                Value& root,
+                                bool collectComments) {
   document_ = document;
   const char* begin = document_.c_str();
   const char* end = begin + document_.length();
   return parse(begin, end, root, collectComments);
 }
 
-bool Reader::parse(std::istream& sin, Value& root, bool collectComments) {
+template <class Policy>
+bool BasicReader<Policy>::parse(std::istream& sin,
+                                Value& root,
+                                bool collectComments) {
   // std::istream_iterator<char> begin(sin);
   // std::istream_iterator<char> end;
   // Those would allow streamed input from a file, if parse() were a
@@ -94,16 +668,98 @@ bool Reader::parse(std::istream& sin, Value& root, bool collectComments) {
 
   // Since std::string is reference-counted, this at least does not
   // create an extra copy.
-  std::string doc;
-  std::getline(sin, doc, (char)EOF);
-  return parse(doc, root, collectComments);
+  std::getline(sin, document_, (char)EOF);
+  const char* begin = document_.c_str();
+  const char* end = begin + document_.length();
+  return parse(begin, end, root, collectComments);
+}
+
+template <class Policy>
+bool BasicReader<Policy>::parseFile(const std::string& path,
+                                    Value& root,
+                                    bool collectComments) {
+  if (!mappedDocument_.open(path)) {
+    begin_ = end_ = current_ = 0;
+    token_.type_ = tokenError;
+    token_.start_ = token_.end_ = 0;
+    errors_.clear();
+    addError(("Unable to map file '" + path + "'.").c_str());
+    return false;
+  }
+  return parse(
+      mappedDocument_.begin(), mappedDocument_.end(), root, collectComments);
+}
+
+template <class Policy>
+void BasicReader<Policy>::setKeyTable(KeyTable* table) {
+  keyTable_ = table;
+}
+
+template <class Policy> void BasicReader<Policy>::reset() {
+  Errors().swap(errors_);
+  std::string().swap(document_);
+  mappedDocument_.close();
+  begin_ = end_ = current_ = lastValueEnd_ = 0;
+  lastValue_ = 0;
+  token_.type_ = tokenEndOfStream;
+  token_.start_ = token_.end_ = 0;
+  std::string().swap(commentsBefore_);
+  std::string().swap(stringBuffer_);
+  Nodes().swap(nodes_);
+  Visited().swap(visited_);
+}
+
+template <class Policy>
+bool BasicReader<Policy>::parse(const char* beginDoc,
+                                const char* endDoc,
+                                Value& root,
+                                bool collectComments) {
+  inSitu_ = false;
+  return readDocument(beginDoc, endDoc, root, collectComments);
+}
+
+template <class Policy>
+bool BasicReader<Policy>::parseInSitu(char* beginDoc,
+                                      char* endDoc,
+                                      Value& root,
+                                      bool collectComments) {
+  inSitu_ = true;
+  return readDocument(beginDoc, endDoc, root, collectComments);
+}
+
+template <class Policy>
+bool BasicReader<Policy>::parseInto(const std::string& document,
+                                    Value& root,
+                                    bool reuse) {
+  document_ = document;
+  const char* begin = document_.c_str();
+  const char* end = begin + document_.length();
+  return parseInto(begin, end, root, reuse);
 }
 
-bool Reader::parse(const char* beginDoc,
-                   const char* endDoc,
-                   Value& root,
-                   bool collectComments) {
-  if (!features_.allowComments_) {
+template <class Policy>
+bool BasicReader<Policy>::parseInto(const char* beginDoc,
+                                    const char* endDoc,
+                                    Value& root,
+                                    bool reuse) {
+  if (!reuse)
+    return parse(beginDoc, endDoc, root);
+  inSitu_ = false;
+  reuse_ = true;
+  root.dropComments();
+  root.setOffsetStart(0);
+  root.setOffsetLimit(0);
+  const bool successful = readDocument(beginDoc, endDoc, root, true);
+  reuse_ = false;
+  return successful;
+}
+
+template <class Policy>
+bool BasicReader<Policy>::readDocument(const char* beginDoc,
+                                       const char* endDoc,
+                                       Value& root,
+                                       bool collectComments) {
+  if (!policy_.allowComments()) {
     collectComments = false;
   }
 
@@ -111,14 +767,15 @@ bool Reader::parse(const char* beginDoc,
   end_ = endDoc;
   collectComments_ = collectComments;
   current_ = begin_;
-  std::string queuedComments;
+  std::string& queuedComments = commentsBefore_;
+  queuedComments.resize(0);
   errors_.clear();
   skipCommentTokens(queuedComments);
   if (!queuedComments.empty()) {
     root.setComment(queuedComments.c_str(), commentBefore);
     queuedComments.resize(0);
   }
-  if (features_.strictRoot_) {
+  if (policy_.strictRoot()) {
     if (token_.type_ != tokenArrayBegin && token_.type_ != tokenObjectBegin) {
       addError(
           "A valid JSON document must be either an array or an object value.");
@@ -126,6 +783,7 @@ bool Reader::parse(const char* beginDoc,
     }
   }
   bool successful = readValue(root);
+  queuedComments.resize(0);
   skipCommentTokens(queuedComments, &root);
   if (!queuedComments.empty()) {
     root.setComment(queuedComments.c_str(), commentAfter);
@@ -134,98 +792,449 @@ bool Reader::parse(const char* beginDoc,
   return successful;
 }
 
-bool Reader::readValue(Value& currentValue) {
-  bool successful = true;
-  currentValue.setOffsetStart(token_.start_ - begin_);
-  switch (token_.type_) {
-  case tokenObjectBegin:
-    successful = readObject(currentValue);
-    break;
-  case tokenArrayBegin:
-    successful = readArray(currentValue);
-    break;
-  case tokenNumber:
-    successful = decodeNumber(currentValue);
-    break;
-  case tokenString:
-    successful = decodeString(currentValue);
-    break;
-  case tokenTrue:
-    Value(true).swapPayload(currentValue);
-    break;
-  case tokenFalse:
-    Value(false).swapPayload(currentValue);
-    break;
-  case tokenArraySeparator:
-    if (features_.allowDroppedNullPlaceholders_) {
-    case tokenNull:
-      Value().swapPayload(currentValue);
-      break;
+template <class Policy>
+bool BasicReader<Policy>::parse(const char* beginDoc,
+                                const char* endDoc,
+                                ReaderHandler& handler) {
+  return readDocument(beginDoc, endDoc, handler, true);
+}
+
+template <class Policy>
+bool BasicReader<Policy>::validate(const char* beginDoc, const char* endDoc) {
+  ReaderHandler validator;
+  return readDocument(beginDoc, endDoc, validator, false);
+}
+
+template <class Policy>
+bool BasicReader<Policy>::readDocument(const char* beginDoc,
+                                       const char* endDoc,
+                                       ReaderHandler& handler,
+                                       bool decode) {
+  inSitu_ = false;
+  begin_ = beginDoc;
+  end_ = endDoc;
+  collectComments_ = false;
+  current_ = begin_;
+  errors_.clear();
+  skipCommentTokens();
+  if (policy_.strictRoot()) {
+    if (token_.type_ != tokenArrayBegin && token_.type_ != tokenObjectBegin) {
+      addError(
+          "A valid JSON document must be either an array or an object value.");
+      return false;
     }
-    // fall through
-  default:
-    successful = false;
-    addError("Syntax error: value, object or array expected.");
-    break;
   }
-  currentValue.setOffsetLimit(token_.end_ - begin_);
-  return successful;
+  return readValue(handler, decode);
 }
 
-bool Reader::skipCommentTokens(std::string& queuedComments, Value* lastValue) {
-  // deal with comment before comma but not on same line as lastValue
-  if (lastValue && !queuedComments.empty()) {
-    lastValue->setComment(queuedComments.c_str(), commentAfter);
-    queuedComments.resize(0);
-    lastValue = 0; // don't put comment after comma on same line as lastValue
+template <class Policy>
+bool BasicReader<Policy>::parse(const char* beginDoc,
+                                const char* endDoc,
+                                const std::vector<Path>& paths,
+                                Value& root) {
+  begin_ = beginDoc;
+  end_ = endDoc;
+  collectComments_ = false;
+  inSitu_ = false;
+  current_ = begin_;
+  errors_.clear();
+  root = Value();
+  if (paths.empty())
+    return true;
+  skipCommentTokens();
+  if (policy_.strictRoot()) {
+    if (token_.type_ != tokenArrayBegin && token_.type_ != tokenObjectBegin) {
+      addError(
+          "A valid JSON document must be either an array or an object value.");
+      return false;
+    }
   }
-  bool found = false;
-  do {
-    if (readToken())
-      lastValue = 0;
-    if (token_.type_ != tokenComment)
-      break;
-    found = true;
-    if (collectComments_) {
-      if (lastValue && !containsNewLine(token_.start_, token_.end_)) {
-        std::string inlineComments = lastValue->getComment(commentAfterOnSameLine);
-        if (!inlineComments.empty())
-          inlineComments.push_back(' ');
-        inlineComments.append(token_.start_, token_.end_);
-        lastValue->setComment(inlineComments.c_str(), commentAfterOnSameLine);
+  Selection selection(paths, root);
+  PathIndexes candidates;
+  for (size_t index = 0; index < paths.size(); ++index)
+    candidates.push_back(index);
+  return readSelection(selection, candidates, 0);
+}
+
+// Reads the value starting at token_, whose descendants at \a depth below it
+// may be selected by the \a candidates paths.
+template <class Policy>
+bool BasicReader<Policy>::readSelection(Selection& selection,
+                                        const PathIndexes& candidates,
+                                        size_t depth) {
+  bool keys = false;
+  bool indexes = false;
+  PathIndexes::const_iterator it;
+  for (it = candidates.begin(); it != candidates.end(); ++it) {
+    const Path& path = selection.paths_[*it];
+    if (path.args_.size() == depth) {
+      // The value is selected, with everything below it.
+      resolvePaths(selection, candidates);
+      return readValue(path.make(selection.root_), depth);
+    }
+    keys = keys || path.args_[depth].kind_ == PathArgument::kindKey;
+    indexes = indexes || path.args_[depth].kind_ == PathArgument::kindIndex;
+  }
+  const bool object = token_.type_ == tokenObjectBegin;
+  if (!(object ? keys : token_.type_ == tokenArrayBegin && indexes)) {
+    resolvePaths(selection, candidates);
+    return skipValue(depth);
+  }
+  if (depth >= policy_.maxDepth()) {
+    addError("Exceeded the maximum nesting depth.");
+    return false;
+  }
+
+  const TokenType endToken = object ? tokenObjectEnd : tokenArrayEnd;
+  PathIndexes selected;
+  ArrayIndex index = 0;
+  bool afterValue = false;
+  for (;;) {
+    if (afterValue && token_.type_ != tokenArraySeparator) {
+      skipCommentTokens();
+      if (token_.type_ != tokenArraySeparator) {
+        if (token_.type_ == endToken)
+          break;
+        addError(object ? "Missing ',' or '}' in object declaration"
+                        : "Missing ',' or ']' in array declaration");
+        return false;
+      }
+    }
+    skipCommentTokens();
+    if (token_.type_ == endToken &&
+        (!afterValue || policy_.allowDroppedNullPlaceholders()))
+      break; // empty container or trailing comma
+
+    selected.clear();
+    if (object) {
+      if (token_.type_ == tokenString) {
+        if (!decodeString(stringBuffer_))
+          return false;
+      } else if (token_.type_ == tokenNumber && policy_.allowNumericKeys()) {
+        Value numberName;
+        if (!decodeNumber(numberName))
+          return false;
+        stringBuffer_ = numberName.asString();
       } else {
-        if (!queuedComments.empty())
-          queuedComments.push_back('\n');
-        const std::string::size_type offset = queuedComments.length();
-        queuedComments.append(token_.start_, token_.end_);
-        const std::string::iterator begin = queuedComments.begin();
-        const std::string::iterator end = queuedComments.end();
-        queuedComments.erase(normalizeEOL(begin + offset, end), end);
+        addError("Missing '}' or object member name");
+        return false;
+      }
+      for (it = candidates.begin(); it != candidates.end(); ++it) {
+        const PathArgument& arg = selection.paths_[*it].args_[depth];
+        if (!selection.resolved_[*it] && arg.kind_ == PathArgument::kindKey &&
+            arg.key_ == stringBuffer_)
+          selected.push_back(*it);
+      }
+      skipCommentTokens();
+      if (token_.type_ != tokenMemberSeparator) {
+        addError("Missing ':' after object member name");
+        return false;
       }
+      skipCommentTokens();
+    } else {
+      for (it = candidates.begin(); it != candidates.end(); ++it) {
+        const PathArgument& arg = selection.paths_[*it].args_[depth];
+        if (!selection.resolved_[*it] &&
+            arg.kind_ == PathArgument::kindIndex && arg.index_ == index)
+          selected.push_back(*it);
+      }
+      ++index;
     }
-  } while (features_.allowComments_);
-  return found;
+    if (selected.empty() ? !skipValue(depth + 1)
+                         : !readSelection(selection, selected, depth + 1))
+      return false;
+    if (selection.remaining_ == 0)
+      return true; // stop early
+    afterValue = true;
+  }
+  // The paths that were not found are missing from the document.
+  resolvePaths(selection, candidates);
+  return true;
 }
 
-bool Reader::readToken() {
-  bool linebreak = false;
-  while (current_ != end_) {
-    Char c = *current_;
-    if (c == '\r' || c == '\n')
-      linebreak = true;
-    else if (c != ' ' && c != '\t')
-      break;
-    ++current_;
+template <class Policy>
+void BasicReader<Policy>::resolvePaths(Selection& selection,
+                                       const PathIndexes& candidates) {
+  for (PathIndexes::const_iterator it = candidates.begin();
+       it != candidates.end();
+       ++it) {
+    if (!selection.resolved_[*it]) {
+      selection.resolved_[*it] = true;
+      --selection.remaining_;
+    }
   }
-  token_.type_ = tokenError;
-  token_.start_ = current_;
-  Char c = getNextChar();
-  switch (c) {
-  case '{':
-    token_.type_ = tokenObjectBegin;
-    break;
-  case '}':
-    token_.type_ = tokenObjectEnd;
+}
+
+// Validates the value starting at token_ without building it.
+template <class Policy> bool BasicReader<Policy>::skipValue(size_t depth) {
+  ReaderHandler skipper;
+  return readValue(skipper, false, depth);
+}
+
+// The value starting at token_ is nested in \a depth arrays or objects, which
+// count towards the maximum nesting depth.
+template <class Policy>
+bool BasicReader<Policy>::readValue(Value& root, size_t depth) {
+  std::string& name = stringBuffer_;
+  const char* inSituName;
+  std::string& queuedComments = commentsBefore_;
+  bool comment = false;
+  queuedComments.resize(0);
+  nodes_.clear();
+  visited_.clear();
+  Value* currentValue = &root;
+  for (;;) {
+    bool successful = true;
+    bool opened = false;
+    if (storeOffsets())
+      currentValue->setOffsetStart(token_.start_ - begin_);
+    switch (token_.type_) {
+    case tokenObjectBegin:
+    case tokenArrayBegin:
+      if (depth + nodes_.size() >= policy_.maxDepth()) {
+        successful = false;
+        addError("Exceeded the maximum nesting depth.");
+        break;
+      }
+      opened = true;
+      {
+        // parseInto() keeps the members of a container of the same type.
+        const ValueType type =
+            token_.type_ == tokenObjectBegin ? objectValue : arrayValue;
+        const bool reused = reuse_ && currentValue->type() == type;
+        if (!reused)
+          Value(type).swapPayload(*currentValue);
+        nodes_.push_back(
+            Node(currentValue, type == objectValue, reused, visited_.size()));
+      }
+      break;
+    case tokenNumber:
+      successful = decodeNumber(*currentValue);
+      break;
+    case tokenString:
+      successful = decodeString(*currentValue);
+      break;
+    case tokenTrue:
+      Value(true).swapPayload(*currentValue);
+      break;
+    case tokenFalse:
+      Value(false).swapPayload(*currentValue);
+      break;
+    case tokenArraySeparator:
+      if (policy_.allowDroppedNullPlaceholders()) {
+      case tokenNull:
+        Value().swapPayload(*currentValue);
+        break;
+      }
+      // fall through
+    default:
+      successful = false;
+      addError("Syntax error: value, object or array expected.");
+      break;
+    }
+    if (!opened && storeOffsets())
+      currentValue->setOffsetLimit(token_.end_ - begin_);
+    if (!successful)
+      return abandonNodes();
+
+    // Find the next value to read, closing the containers that end before it.
+    bool afterValue = !opened;
+    for (;;) {
+      if (nodes_.empty())
+        return true;
+      Node& node = nodes_.back();
+      Value& container = *node.value_;
+      const TokenType endToken = node.object_ ? tokenObjectEnd : tokenArrayEnd;
+      if (afterValue)
+        comment = token_.type_ != tokenArraySeparator &&
+                  skipCommentTokens(queuedComments, node.lastValue_);
+      if (!afterValue || token_.type_ == tokenArraySeparator) {
+        comment = skipCommentTokens(queuedComments, node.lastValue_);
+        if (token_.type_ != endToken ||
+            (node.lastValue_ != 0 && !policy_.allowDroppedNullPlaceholders())) {
+          if (node.object_) {
+            // The name is decoded straight into the storage of the key.
+            inSituName = 0;
+            char* ownedName = 0;
+            size_t nameLength = 0;
+            if (token_.type_ == tokenString) {
+              // The name is looked up among the kept members of a reused
+              // object, or in the key table, so it is decoded into a buffer
+              // instead.
+              const bool buffered = node.reused_ || (keyTable_ && !inSitu_);
+              if (buffered ? !decodeString(name)
+                  : inSitu_ ? !decodeStringInSitu(inSituName, nameLength)
+                            : !decodeStringAllocated(ownedName, nameLength))
+                return abandonNodes();
+            } else if (token_.type_ == tokenNumber &&
+                       policy_.allowNumericKeys()) {
+              Value numberName;
+              if (!decodeNumber(numberName))
+                return abandonNodes();
+              name = numberName.asString();
+            } else {
+              addError("Missing '}' or object member name");
+              return abandonNodes();
+            }
+            skipCommentTokens(queuedComments);
+            if (token_.type_ != tokenMemberSeparator) {
+              free(ownedName);
+              addError("Missing ':' after object member name");
+              return abandonNodes();
+            }
+            skipCommentTokens(queuedComments);
+            const char* key = name.data();
+            if (keyTable_ && !inSituName)
+              key = keyTable_->intern(key, key + name.size());
+            if (node.reused_) {
+              // Members may move as the object grows: they are recorded by
+              // an id that stays valid rather than by their address.
+              const void* id;
+              currentValue = &container.resolveMember(
+                  key, name.size(), keyTable_ != 0, id);
+              visited_.push_back(id);
+            } else if (inSituName) {
+              currentValue =
+                  &container.resolveReference(inSituName, nameLength, true);
+            } else if (ownedName) {
+              currentValue = &container.adoptMember(ownedName, nameLength);
+            } else {
+              currentValue =
+                  &container.resolveReference(key, name.size(), keyTable_ != 0);
+            }
+          } else {
+            currentValue = &container[node.size_++];
+          }
+          if (node.reused_) {
+            currentValue->dropComments();
+            if (!storeOffsets()) {
+              currentValue->setOffsetStart(0);
+              currentValue->setOffsetLimit(0);
+            }
+          }
+          if (!queuedComments.empty()) {
+            currentValue->setComment(queuedComments.c_str(), commentBefore);
+            queuedComments.resize(0);
+          }
+          node.lastValue_ = currentValue;
+          break;
+        }
+        // empty container or trailing comma
+      } else if (token_.type_ != endToken) {
+        addError(node.object_ ? "Missing ',' or '}' in object declaration"
+                              : "Missing ',' or ']' in array declaration");
+        return abandonNodes();
+      }
+      if (comment) {
+        if (node.lastValue_ == 0) {
+          std::string comment = container.getComment(commentBefore);
+          if (!comment.empty())
+            comment.push_back('\n');
+          comment.append(queuedComments);
+          container.setComment(comment.c_str(), commentBefore);
+        } else if (!queuedComments.empty()) {
+          node.lastValue_->setComment(queuedComments.c_str(), commentAfter);
+        }
+      }
+      queuedComments.resize(0);
+      if (node.reused_)
+        retainMembers(node);
+      if (storeOffsets())
+        container.setOffsetLimit(token_.end_ - begin_);
+      nodes_.pop_back();
+      afterValue = true;
+    }
+  }
+}
+
+// Removes the members of a container kept by parseInto() that were not read
+// again.
+template <class Policy>
+void BasicReader<Policy>::retainMembers(const Node& node) {
+  Value& container = *node.value_;
+  if (!node.object_) {
+    if (container.size() > node.size_)
+      container.resize(node.size_);
+    return;
+  }
+  const void** begin = visited_.empty() ? 0 : &visited_[0] + node.visited_;
+  const void** end = begin + (visited_.size() - node.visited_);
+  std::sort(begin, end);
+  end = std::unique(begin, end);
+  if (ArrayIndex(end - begin) != container.size())
+    container.retainMembers(begin, end);
+  visited_.resize(node.visited_);
+}
+
+template <class Policy> bool BasicReader<Policy>::abandonNodes() {
+  // error already set
+  if (!storeOffsets()) {
+    nodes_.clear();
+    return false;
+  }
+  while (!nodes_.empty()) {
+    nodes_.back().value_->setOffsetLimit(token_.end_ - begin_);
+    nodes_.pop_back();
+  }
+  return false;
+}
+
+template <class Policy>
+bool BasicReader<Policy>::skipCommentTokens(std::string& queuedComments,
+                                            Value* lastValue) {
+  // deal with comment before comma but not on same line as lastValue
+  if (lastValue && !queuedComments.empty()) {
+    lastValue->setComment(queuedComments.c_str(), commentAfter);
+    queuedComments.resize(0);
+    lastValue = 0; // don't put comment after comma on same line as lastValue
+  }
+  bool found = false;
+  do {
+    if (readToken())
+      lastValue = 0;
+    if (token_.type_ != tokenComment)
+      break;
+    found = true;
+    if (collectComments_) {
+      if (lastValue && !containsNewLine(token_.start_, token_.end_)) {
+        std::string inlineComments = lastValue->getComment(commentAfterOnSameLine);
+        if (!inlineComments.empty())
+          inlineComments.push_back(' ');
+        inlineComments.append(token_.start_, token_.end_);
+        lastValue->setComment(inlineComments.c_str(), commentAfterOnSameLine);
+      } else {
+        if (!queuedComments.empty())
+          queuedComments.push_back('\n');
+        const std::string::size_type offset = queuedComments.length();
+        queuedComments.append(token_.start_, token_.end_);
+        const std::string::iterator begin = queuedComments.begin();
+        const std::string::iterator end = queuedComments.end();
+        queuedComments.erase(normalizeEOL(begin + offset, end), end);
+      }
+    }
+  } while (policy_.allowComments());
+  return found;
+}
+
+template <class Policy>
+void BasicReader<Policy>::skipCommentTokens() {
+  do
+    readToken();
+  while (token_.type_ == tokenComment && policy_.allowComments());
+}
+
+bool ReaderBase::readToken() {
+  bool linebreak = false;
+  current_ = skipWhitespace(current_, end_, linebreak);
+  token_.type_ = tokenError;
+  token_.start_ = current_;
+  Char c = getNextChar();
+  switch (c) {
+  case '{':
+    token_.type_ = tokenObjectBegin;
+    break;
+  case '}':
+    token_.type_ = tokenObjectEnd;
     break;
   case '[':
     token_.type_ = tokenArrayBegin;
@@ -283,7 +1292,7 @@ bool Reader::readToken() {
   return linebreak;
 }
 
-Reader::TokenType Reader::match(const Char *pattern, TokenType type) {
+ReaderBase::TokenType ReaderBase::match(const Char* pattern, TokenType type) {
   int ahead = static_cast<int>(end_ - current_);
   int index = 0;
   while (Char c = *++pattern)
@@ -293,7 +1302,7 @@ Reader::TokenType Reader::match(const Char *pattern, TokenType type) {
   return type;
 }
 
-Reader::TokenType Reader::readCStyleComment() {
+ReaderBase::TokenType ReaderBase::readCStyleComment() {
   Char b, c = '\0';
   while (current_ != end_) {
     b = c;
@@ -304,7 +1313,7 @@ Reader::TokenType Reader::readCStyleComment() {
   return tokenError;
 }
 
-Reader::TokenType Reader::readCppStyleComment() {
+ReaderBase::TokenType ReaderBase::readCppStyleComment() {
   while (current_ != end_) {
     Char c = *current_;
     if (c == '\r' || c == '\n')
@@ -314,7 +1323,7 @@ Reader::TokenType Reader::readCppStyleComment() {
   return tokenComment;
 }
 
-Reader::TokenType Reader::readNumber() {
+ReaderBase::TokenType ReaderBase::readNumber() {
   const char *p = current_;
   char c = '0'; // stopgap for already consumed character
   // integral part
@@ -337,191 +1346,314 @@ Reader::TokenType Reader::readNumber() {
   return tokenNumber;
 }
 
-Reader::TokenType Reader::readString() {
-  while (Char c = getNextChar()) {
+ReaderBase::TokenType ReaderBase::readString() {
+  for (;;) {
+    current_ = scanStringContent(current_, end_);
+    Char c = getNextChar();
     if (c == '"')
       return tokenString;
-    if (c == '\\')
-      getNextChar();
+    if (c != '\\')
+      return tokenError;
+    getNextChar();
   }
-  return tokenError;
 }
 
-bool Reader::readObject(Value& currentValue) {
-  std::string name;
-  Value(objectValue).swapPayload(currentValue);
-  std::string queuedComments;
-  Value* lastValue = 0;
-  bool comment;
-  do {
-    comment = skipCommentTokens(queuedComments, lastValue);
-    if (token_.type_ == tokenObjectEnd)
-      if (lastValue == 0 || features_.allowDroppedNullPlaceholders_)
-        break; // empty object or trailing comma
-    if (token_.type_ == tokenString) {
-      if (!decodeString(name))
+// Without \a decode, numbers, strings and member names are only validated,
+// and are not reported to \a handler. As for readValue(Value&, size_t), the
+// value is nested in \a depth arrays or objects.
+template <class Policy>
+bool BasicReader<Policy>::readValue(ReaderHandler& handler,
+                                    bool decode,
+                                    size_t depth) {
+  nodes_.clear();
+  for (;;) {
+    bool opened = false;
+    switch (token_.type_) {
+    case tokenObjectBegin:
+    case tokenArrayBegin:
+      if (depth + nodes_.size() >= policy_.maxDepth()) {
+        addError("Exceeded the maximum nesting depth.");
         return false;
-    } else if (token_.type_ == tokenNumber && features_.allowNumericKeys_) {
-      Value numberName;
-      if (!decodeNumber(numberName))
+      }
+      opened = true;
+      nodes_.push_back(Node(0, token_.type_ == tokenObjectBegin));
+      if (!(nodes_.back().object_ ? handler.startObject()
+                                  : handler.startArray()))
         return false;
-      name = numberName.asString();
-    } else {
-      addError("Missing '}' or object member name");
-      return false;
-    }
-    skipCommentTokens(queuedComments);
-    if (token_.type_ != tokenMemberSeparator) {
-      addError("Missing ':' after object member name");
-      return false;
-    }
-    skipCommentTokens(queuedComments);
-    Value& value = currentValue[name];
-    if (!queuedComments.empty()) {
-      value.setComment(queuedComments.c_str(), commentBefore);
-      queuedComments.resize(0);
-    }
-    lastValue = &value;
-    if (!readValue(value)) {
-      // error already set
+      break;
+    case tokenNumber:
+      if (decode ? !decodeNumber(handler) : !validateNumber())
+        return false;
+      break;
+    case tokenString:
+      if (!decode) {
+        if (!validateString())
+          return false;
+      } else if (!decodeString(stringBuffer_) ||
+                 !handler.string(stringBuffer_.data(),
+                                 stringBuffer_.data() + stringBuffer_.size()))
+        return false;
+      break;
+    case tokenTrue:
+      if (!handler.boolean(true))
+        return false;
+      break;
+    case tokenFalse:
+      if (!handler.boolean(false))
+        return false;
+      break;
+    case tokenArraySeparator:
+      if (policy_.allowDroppedNullPlaceholders()) {
+      case tokenNull:
+        if (!handler.null())
+          return false;
+        break;
+      }
+      // fall through
+    default:
+      addError("Syntax error: value, object or array expected.");
       return false;
     }
-    comment = token_.type_ != tokenArraySeparator &&
-              skipCommentTokens(queuedComments, lastValue);
-  } while (token_.type_ == tokenArraySeparator);
-  if (token_.type_ != tokenObjectEnd) {
-    addError("Missing ',' or '}' in object declaration");
-    return false;
-  }
-  if (comment) {
-    if (lastValue == 0) {
-      std::string comment = currentValue.getComment(commentBefore);
-      if (!comment.empty())
-        comment.push_back('\n');
-      comment.append(queuedComments);
-      currentValue.setComment(comment.c_str(), commentBefore);
-    } else if (!queuedComments.empty()) {
-      lastValue->setComment(queuedComments.c_str(), commentAfter);
+
+    // Find the next value to read, closing the containers that end before it.
+    bool afterValue = !opened;
+    for (;;) {
+      if (nodes_.empty())
+        return true;
+      const bool object = nodes_.back().object_;
+      const TokenType endToken = object ? tokenObjectEnd : tokenArrayEnd;
+      if (afterValue && token_.type_ != tokenArraySeparator)
+        skipCommentTokens();
+      if (!afterValue || token_.type_ == tokenArraySeparator) {
+        skipCommentTokens();
+        if (token_.type_ != endToken ||
+            (afterValue && !policy_.allowDroppedNullPlaceholders())) {
+          if (object) {
+            if (token_.type_ == tokenString) {
+              if (decode ? !decodeString(stringBuffer_) : !validateString())
+                return false;
+            } else if (token_.type_ == tokenNumber &&
+                       policy_.allowNumericKeys()) {
+              if (!decode) {
+                if (!validateNumber())
+                  return false;
+              } else {
+                Value numberName;
+                if (!decodeNumber(numberName))
+                  return false;
+                stringBuffer_ = numberName.asString();
+              }
+            } else {
+              addError("Missing '}' or object member name");
+              return false;
+            }
+            if (decode &&
+                !handler.key(stringBuffer_.data(),
+                             stringBuffer_.data() + stringBuffer_.size()))
+              return false;
+            skipCommentTokens();
+            if (token_.type_ != tokenMemberSeparator) {
+              addError("Missing ':' after object member name");
+              return false;
+            }
+            skipCommentTokens();
+          }
+          break;
+        }
+        // empty container or trailing comma
+      } else if (token_.type_ != endToken) {
+        addError(object ? "Missing ',' or '}' in object declaration"
+                        : "Missing ',' or ']' in array declaration");
+        return false;
+      }
+      nodes_.pop_back();
+      if (!(object ? handler.endObject() : handler.endArray()))
+        return false;
+      afterValue = true;
     }
   }
-  return true;
 }
 
-bool Reader::readArray(Value& currentValue) {
-  Value(arrayValue).swapPayload(currentValue);
-  int index = 0;
-  std::string queuedComments;
-  Value* lastValue = 0;
-  bool comment;
-  do {
-    comment = skipCommentTokens(queuedComments, lastValue);
-    if (token_.type_ == tokenArrayEnd)
-      if (lastValue == 0 || features_.allowDroppedNullPlaceholders_)
-        break; // empty array or trailing comma
-    Value& value = currentValue[index++];
-    if (!queuedComments.empty()) {
-      value.setComment(queuedComments.c_str(), commentBefore);
-      queuedComments.resize(0);
-    }
-    lastValue = &value;
-    if (!readValue(value)) {
-      // error already set
-      return false;
-    }
-    comment = token_.type_ != tokenArraySeparator &&
-              skipCommentTokens(queuedComments, lastValue);
-  } while (token_.type_ == tokenArraySeparator);
-  if (token_.type_ != tokenArrayEnd) {
-    addError("Missing ',' or ']' in array declaration");
+bool ReaderBase::decodeNumber(ReaderHandler& handler) {
+  Value number;
+  if (!decodeNumber(number))
     return false;
+  switch (number.type()) {
+  case intValue:
+    return handler.integer(number.asLargestInt());
+  case uintValue:
+    return handler.unsignedInteger(number.asLargestUInt());
+  default:
+    return handler.real(number.asDouble());
   }
-  if (comment) {
-    if (lastValue == 0) {
-      std::string comment = currentValue.getComment(commentBefore);
-      if (!comment.empty())
-        comment.push_back('\n');
-      comment.append(queuedComments);
-      currentValue.setComment(comment.c_str(), commentBefore);
-    } else if (!queuedComments.empty()) {
-      lastValue->setComment(queuedComments.c_str(), commentAfter);
-    }
-  }
-  return true;
 }
 
-bool Reader::decodeNumber(Value& currentValue) {
+bool ReaderBase::decodeNumber(Value& currentValue) {
   Location current = token_.start_;
-  bool isNegative = *current == '-';
+  Location end = token_.end_;
+  bool isNegative = current != end && *current == '-';
   if (isNegative)
     ++current;
+  Location digits = current;
+  while (current != end && *current == '0')
+    ++current;
+  Location significantDigits = current;
+  // Up to digits10 significant digits can not overflow.
+  const int safeDigits = std::numeric_limits<Value::LargestUInt>::digits10;
   Value::LargestUInt value = 0;
-  bool isSigned = true;
-  bool isUnsigned = true;
-  while (current < token_.end_) {
-    Char c = *current++;
-    if (c < '0' || c > '9') {
-      isSigned = false;
-      isUnsigned = false;
+#if defined(JSON_HAS_INT64)
+  for (int chunk = 0; chunk < safeDigits / 8 && end - current >= 8; ++chunk) {
+    UInt64 chars = loadEightChars(current);
+    if (!isEightDigits(chars))
       break;
-    }
-    Value::LargestUInt val = value;
-    Value::LargestUInt delta = Value::LargestUInt(c - '0');
-    for (int i = 0; i < 10; ++i) {
-      value += delta;
-      if (-Value::LargestInt(value) > -Value::LargestInt(delta))
-        isSigned = false;
-      if (value < delta)
-        isUnsigned = false;
-      delta = val;
+    value = value * 100000000 + parseEightDigits(chars);
+    current += 8;
+  }
+#endif
+  while (current != end && current - significantDigits < safeDigits &&
+         *current >= '0' && *current <= '9')
+    value = value * 10 + Value::LargestUInt(*current++ - '0');
+  if (current != end && *current >= '0' && *current <= '9') {
+    // Only the last digit of the largest values needs an overflow check.
+    Value::LargestUInt digit = Value::LargestUInt(*current - '0');
+    if (value <= (Value::maxLargestUInt - digit) / 10) {
+      value = value * 10 + digit;
+      ++current;
     }
   }
-  if (isSigned && (isNegative || Value::LargestInt(value) >= 0))
-    Value(isNegative ? -Value::LargestInt(value) : Value::LargestInt(value)).swapPayload(currentValue);
-  else if (isUnsigned && !isNegative)
+  // Fractions, exponents, values out of range and "-" are left to
+  // decodeDouble().
+  if (current != end || current == digits)
+    return decodeDouble(currentValue);
+  if (isNegative) {
+    if (value > Value::LargestUInt(Value::maxLargestInt) + 1)
+      return decodeDouble(currentValue);
+    // -(value - 1) - 1 does not overflow for minLargestInt.
+    Value::LargestInt negated =
+        value ? -Value::LargestInt(value - 1) - 1 : Value::LargestInt(0);
+    Value(negated).swapPayload(currentValue);
+  } else if (value <= Value::LargestUInt(Value::maxLargestInt)) {
+    Value(Value::LargestInt(value)).swapPayload(currentValue);
+  } else {
     Value(value).swapPayload(currentValue);
-  else {
-    double value = 0;
-    const int bufferSize = 64;
-    int count;
-    int length = token_.length();
-    // Avoid using a string constant for the format control string given to
-    // sscanf, as this can cause hard to debug crashes on OS X. See here for more
-    // info:
-    //
-    //     http://developer.apple.com/library/mac/#DOCUMENTATION/DeveloperTools/gcc-4.0.1/gcc/Incompatibilities.html
-    static const char format[] = "%lf%c";
-    if (length <= bufferSize) {
-      Char buffer[bufferSize + 1];
-      memcpy(buffer, token_.start_, length);
-      buffer[length] = 0;
-      count = sscanf(buffer, format, &value, &count);
-    } else {
-      count = sscanf(token_.asString().c_str(), format, &value, &count);
-    }
-    if (count != 1) {
-      addError(("'" + token_.asString() + "' is not a number.").c_str());
+  }
+  return true;
+}
+
+bool ReaderBase::validateNumber() {
+  Location current = token_.start_;
+  Location end = token_.end_;
+  if (current != end && *current == '-')
+    ++current;
+  Location digits = current;
+  while (current != end && *current >= '0' && *current <= '9')
+    ++current;
+  if (current == end && current != digits)
+    return true;
+  // As in decodeNumber(), the other numbers must be valid doubles.
+  double value;
+  if (!parseDouble(token_.start_, token_.end_, value)) {
+    addError(("'" + token_.asString() + "' is not a number.").c_str());
+    return false;
+  }
+  return true;
+}
+
+bool ReaderBase::decodeDouble(Value& decoded) {
+  double value;
+  if (!parseDouble(token_.start_, token_.end_, value)) {
+    addError(("'" + token_.asString() + "' is not a number.").c_str());
+    return false;
+  }
+  Value(value).swapPayload(decoded);
+  return true;
+}
+
+bool ReaderBase::decodeString(Value& currentValue) {
+  if (inSitu_) {
+    const char* decoded;
+    size_t length;
+    if (!decodeStringInSitu(decoded, length))
       return false;
-    }
-    Value(value).swapPayload(currentValue);
+    currentValue.referString(decoded, length);
+    return true;
   }
+  // parseInto() decodes over a string at least as long as the token, and a
+  // short string is decoded into the Value itself.
+  const size_t capacity = token_.length() - 2;
+  char* buffer = reuse_ ? currentValue.reusableString(capacity) : 0;
+  if (buffer || (buffer = currentValue.inlineString(capacity))) {
+    size_t length;
+    if (!decodeString(buffer, length))
+      return false;
+    currentValue.setStringLength(length);
+    return true;
+  }
+  char* decoded;
+  size_t length;
+  if (!decodeStringAllocated(decoded, length))
+    return false;
+  currentValue.adoptString(decoded, length);
+  return true;
+}
+
+bool ReaderBase::decodeStringInSitu(const char*& decoded, size_t& length) {
+  // parseInSitu() was given a mutable document.
+  Char* begin = const_cast<Char*>(token_.start_) + 1; // skip '"'
+  if (!decodeString(begin, length))
+    return false;
+  begin[length] = 0; // over the closing '"' at the latest
+  decoded = begin;
+  return true;
+}
+
+bool ReaderBase::decodeStringAllocated(char*& decoded, size_t& length) {
+  // Released by the Value the string is stored in, with free().
+  decoded = static_cast<char*>(malloc(token_.length() - 1));
+  JSON_ASSERT_MESSAGE(decoded != 0,
+                      "in Json::Reader::decodeStringAllocated(): "
+                      "Failed to allocate string value buffer");
+  if (!decodeString(decoded, length)) {
+    free(decoded);
+    return false;
+  }
+  decoded[length] = 0;
   return true;
 }
 
-bool Reader::decodeString(Value& currentValue) {
-  std::string decoded;
-  if (!decodeString(decoded))
+bool ReaderBase::decodeString(std::string& decoded) {
+  decoded.resize(token_.length() - 2);
+  size_t length = 0;
+  if (!decoded.empty() && !decodeString(&decoded[0], length))
     return false;
-  Value(decoded).swapPayload(currentValue);
+  decoded.resize(length);
   return true;
 }
 
-bool Reader::decodeString(std::string& decoded) {
-  decoded.resize(0);
-  decoded.reserve(token_.length() - 2);
+// Returned by decodeUnicodeEscapeSequence(), as "\u0000" decodes to 0.
+static const unsigned invalidCodePoint = ~0u;
+
+// Decodes the string token into \a decoded, which has room for the
+// token_.length() - 2 characters of its content and may be the content
+// itself: an escape sequence is never shorter than the UTF-8 it decodes to.
+bool ReaderBase::decodeString(Char* decoded, size_t& length) {
+  if (validateUTF8_ && !checkUTF8())
+    return false;
   Location current = token_.start_ + 1; // skip '"'
   Location end = token_.end_ - 1; // do not include '"'
+  Char* out = decoded;
   unsigned surrogate = 0;
   while (current < end) {
+    if (surrogate == 0) {
+      // Copy the run of characters up to the next escape sequence at once.
+      Location escape = scanStringContent(current, end);
+      if (out != current)
+        std::memmove(out, current, escape - current);
+      out += escape - current;
+      current = escape;
+      if (current == end)
+        break;
+    }
     Char c = *current++;
     assert(c != '"');
     if (c == '\\') {
@@ -545,34 +1677,37 @@ bool Reader::decodeString(std::string& decoded) {
         break;
       case '"': case '/': case '\\':
         break;
-      case 'u':
-        if (unsigned codepoint = decodeUnicodeEscapeSequence(current, end)) {
-          // Is this a high surrogate?
-          if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
-            // Yes, remember for subsequent iteration
-            if (surrogate != 0) {
-              addError("Misplaced UTF-16 surrogate", current);
-              return false;
-            }
-            surrogate = codepoint;
-            continue;
-          }
-          // Is this a low surrogate?
-          if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) {
-            // Yes, combine with high surrogate
-            if (surrogate == 0) {
-              addError("Misplaced UTF-16 surrogate", current);
-              return false;
-            }
-            codepoint &= 0x3FF;
-            codepoint |= (surrogate & 0x3FF) << 10;
-            codepoint += 0x10000;
-            surrogate = 0;
+      case 'u': {
+        unsigned codepoint = decodeUnicodeEscapeSequence(current, end);
+        if (codepoint == invalidCodePoint) {
+          addError("Bad escape sequence in string", current);
+          return false;
+        }
+        // Is this a high surrogate?
+        if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+          // Yes, remember for subsequent iteration
+          if (surrogate != 0) {
+            addError("Misplaced UTF-16 surrogate", current);
+            return false;
           }
-          decoded += codePointToUTF8(codepoint);
+          surrogate = codepoint;
           continue;
         }
-        // fall through
+        // Is this a low surrogate?
+        if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) {
+          // Yes, combine with high surrogate
+          if (surrogate == 0) {
+            addError("Misplaced UTF-16 surrogate", current);
+            return false;
+          }
+          codepoint &= 0x3FF;
+          codepoint |= (surrogate & 0x3FF) << 10;
+          codepoint += 0x10000;
+          surrogate = 0;
+        }
+        out += encodeUTF8(codepoint, out);
+        continue;
+      }
       default:
         addError("Bad escape sequence in string", current);
         return false;
@@ -582,14 +1717,78 @@ bool Reader::decodeString(std::string& decoded) {
       addError("Misplaced UTF-16 surrogate", current);
       return false;
     }
-    decoded.push_back(c);
+    *out++ = c;
+  }
+  length = out - decoded;
+  return true;
+}
+
+// Reports the first invalid UTF-8 sequence in the string token.
+bool ReaderBase::checkUTF8() {
+  Location begin = token_.start_ + 1; // skip '"'
+  Location end = token_.end_ - 1; // do not include '"'
+  if (isValidUTF8(begin, end))
+    return true;
+  addError("Invalid UTF-8 sequence in string", findInvalidUTF8(begin, end));
+  return false;
+}
+
+// Reports the errors decodeString() would report, without decoding.
+bool ReaderBase::validateString() {
+  if (validateUTF8_ && !checkUTF8())
+    return false;
+  Location current = token_.start_ + 1; // skip '"'
+  Location end = token_.end_ - 1; // do not include '"'
+  unsigned surrogate = 0;
+  while (current < end) {
+    if (surrogate == 0) {
+      // Only escape sequences can be invalid.
+      current = static_cast<Location>(
+          std::memchr(current, '\\', end - current));
+      if (current == 0)
+        return true;
+    }
+    Char c = *current++;
+    if (c == '\\') {
+      c = *current++;
+      if (c == 'u') {
+        unsigned codepoint = decodeUnicodeEscapeSequence(current, end);
+        if (codepoint == invalidCodePoint) {
+          addError("Bad escape sequence in string", current);
+          return false;
+        }
+        if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+          if (surrogate != 0) {
+            addError("Misplaced UTF-16 surrogate", current);
+            return false;
+          }
+          surrogate = codepoint;
+        } else if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) {
+          if (surrogate == 0) {
+            addError("Misplaced UTF-16 surrogate", current);
+            return false;
+          }
+          surrogate = 0;
+        }
+        continue;
+      }
+      if (!std::strchr("bfnrt\"/\\", c) || c == 0) {
+        addError("Bad escape sequence in string", current);
+        return false;
+      }
+    }
+    if (surrogate != 0) {
+      addError("Misplaced UTF-16 surrogate", current);
+      return false;
+    }
   }
   return true;
 }
 
-unsigned Reader::decodeUnicodeEscapeSequence(Location& current, Location end) {
+unsigned ReaderBase::decodeUnicodeEscapeSequence(Location& current,
+                                                 Location end) {
   if (end - current < 4)
-    return 0;
+    return invalidCodePoint;
   unsigned unicode = 0;
   for (int index = 0; index < 4; ++index) {
     Char c = *current++;
@@ -601,12 +1800,12 @@ unsigned Reader::decodeUnicodeEscapeSequence(Location& current, Location end) {
     else if (c >= 'A' && c <= 'F')
       unicode += c - 'A' + 10;
     else
-      return 0;
+      return invalidCodePoint;
   }
   return unicode;
 }
 
-void Reader::addError(const char* message, Location extra) {
+void ReaderBase::addError(const char* message, Location extra) {
   ErrorInfo info;
   info.token_ = token_;
   info.message_ = message;
@@ -614,13 +1813,13 @@ void Reader::addError(const char* message, Location extra) {
   errors_.push_back(info);
 }
 
-Reader::Char Reader::getNextChar() {
+ReaderBase::Char ReaderBase::getNextChar() {
   if (current_ == end_)
     return 0;
   return *current_++;
 }
 
-void Reader::getLocationLineAndColumn(Location location,
+void ReaderBase::getLocationLineAndColumn(Location location,
                                       int& line,
                                       int& column) const {
   Location current = begin_;
@@ -643,7 +1842,7 @@ void Reader::getLocationLineAndColumn(Location location,
   ++line;
 }
 
-std::string Reader::getLocationLineAndColumn(Location location) const {
+std::string ReaderBase::getLocationLineAndColumn(Location location) const {
   int line, column;
   getLocationLineAndColumn(location, line, column);
   char buffer[18 + 16 + 16 + 1];
@@ -660,11 +1859,11 @@ std::string Reader::getLocationLineAndColumn(Location location) const {
 }
 
 // Deprecated. Preserved for backward compatibility
-std::string Reader::getFormatedErrorMessages() const {
+std::string ReaderBase::getFormatedErrorMessages() const {
   return getFormattedErrorMessages();
 }
 
-std::string Reader::getFormattedErrorMessages() const {
+std::string ReaderBase::getFormattedErrorMessages() const {
   std::string formattedMessage;
   for (Errors::const_iterator itError = errors_.begin();
        itError != errors_.end();
@@ -680,7 +1879,8 @@ std::string Reader::getFormattedErrorMessages() const {
   return formattedMessage;
 }
 
-std::vector<Reader::StructuredError> Reader::getStructuredErrors() const {
+std::vector<ReaderBase::StructuredError>
+ReaderBase::getStructuredErrors() const {
   std::vector<Reader::StructuredError> allErrors;
   for (Errors::const_iterator itError = errors_.begin();
        itError != errors_.end();
@@ -695,7 +1895,7 @@ std::vector<Reader::StructuredError> Reader::getStructuredErrors() const {
   return allErrors;
 }
 
-bool Reader::pushError(const Value& value, const std::string& message) {
+bool ReaderBase::pushError(const Value& value, const std::string& message) {
   size_t length = end_ - begin_;
   if(value.getOffsetStart() > length
     || value.getOffsetLimit() > length)
@@ -712,7 +1912,9 @@ bool Reader::pushError(const Value& value, const std::string& message) {
   return true;
 }
 
-bool Reader::pushError(const Value& value, const std::string& message, const Value& extra) {
+bool ReaderBase::pushError(const Value& value,
+                           const std::string& message,
+                           const Value& extra) {
   size_t length = end_ - begin_;
   if(value.getOffsetStart() > length
     || value.getOffsetLimit() > length
@@ -730,10 +1932,1632 @@ bool Reader::pushError(const Value& value, const std::string& message, const Val
   return true;
 }
 
-bool Reader::good() const {
+bool ReaderBase::good() const {
   return !errors_.size();
 }
 
+template class JSON_API BasicReader<RuntimeFeatures>;
+template class JSON_API BasicReader<StrictFeatures>;
+
+// Class Reader
+// //////////////////////////////////////////////////////////////////
+
+Reader::Reader() : BasicReader<RuntimeFeatures>(Features::all()) {}
+
+Reader::Reader(const Features& features)
+    : BasicReader<RuntimeFeatures>(features) {}
+
+// Class JsonCursor
+// //////////////////////////////////////////////////////////////////
+
+JsonCursor::JsonCursor(const char* beginDoc, const char* endDoc)
+    : reader_(), stack_(), type_(tokenEndOfDocument), expect_(expectRoot),
+      first_(false), pending_(false) {
+  initialize(beginDoc, endDoc);
+}
+
+JsonCursor::JsonCursor(const char* beginDoc,
+                       const char* endDoc,
+                       const Features& features)
+    : reader_(features), stack_(), type_(tokenEndOfDocument),
+      expect_(expectRoot), first_(false), pending_(false) {
+  initialize(beginDoc, endDoc);
+}
+
+void JsonCursor::initialize(const char* beginDoc, const char* endDoc) {
+  reader_.begin_ = beginDoc;
+  reader_.end_ = endDoc;
+  reader_.current_ = beginDoc;
+  reader_.collectComments_ = false;
+  reader_.token_.type_ = Reader::tokenEndOfStream;
+  reader_.token_.start_ = beginDoc;
+  reader_.token_.end_ = beginDoc;
+}
+
+bool JsonCursor::next() {
+  if (type_ == tokenError)
+    return false;
+  if (pending_)
+    pending_ = false;
+  else
+    reader_.skipCommentTokens();
+  Reader::TokenType token = reader_.token_.type_;
+  switch (expect_) {
+  case expectRoot:
+    if (reader_.policy_.strictRoot() && token != Reader::tokenArrayBegin &&
+        token != Reader::tokenObjectBegin)
+      return fail(
+          "A valid JSON document must be either an array or an object value.");
+    return beginValue();
+  case expectMember:
+    if (token == Reader::tokenObjectEnd &&
+        (first_ || reader_.policy_.allowDroppedNullPlaceholders()))
+      return endContainer(tokenObjectEnd); // empty object or trailing comma
+    if (token != Reader::tokenString &&
+        (token != Reader::tokenNumber || !reader_.policy_.allowNumericKeys()))
+      return fail("Missing '}' or object member name");
+    first_ = false;
+    type_ = tokenKey;
+    expect_ = expectMemberSeparator;
+    return true;
+  case expectMemberSeparator:
+    if (token != Reader::tokenMemberSeparator)
+      return fail("Missing ':' after object member name");
+    reader_.skipCommentTokens();
+    return beginValue();
+  case expectElement:
+    if (token == Reader::tokenArrayEnd &&
+        (first_ || reader_.policy_.allowDroppedNullPlaceholders()))
+      return endContainer(tokenArrayEnd); // empty array or trailing comma
+    first_ = false;
+    return beginValue();
+  case expectSeparator:
+    if (stack_.back() == '{') {
+      if (token == Reader::tokenObjectEnd)
+        return endContainer(tokenObjectEnd);
+      if (token != Reader::tokenArraySeparator)
+        return fail("Missing ',' or '}' in object declaration");
+      expect_ = expectMember;
+    } else {
+      if (token == Reader::tokenArrayEnd)
+        return endContainer(tokenArrayEnd);
+      if (token != Reader::tokenArraySeparator)
+        return fail("Missing ',' or ']' in array declaration");
+      expect_ = expectElement;
+    }
+    // first_ may still be set by a nested empty container.
+    first_ = false;
+    return next();
+  case expectEnd:
+    break;
+  }
+  type_ = tokenEndOfDocument;
+  return false;
+}
+
+bool JsonCursor::beginValue() {
+  const Reader::TokenType token = reader_.token_.type_;
+  if ((token == Reader::tokenObjectBegin || token == Reader::tokenArrayBegin) &&
+      stack_.size() >= reader_.policy_.maxDepth())
+    return fail("Exceeded the maximum nesting depth.");
+  switch (reader_.token_.type_) {
+  case Reader::tokenObjectBegin:
+    stack_.push_back('{');
+    type_ = tokenObjectBegin;
+    expect_ = expectMember;
+    first_ = true;
+    return true;
+  case Reader::tokenArrayBegin:
+    stack_.push_back('[');
+    type_ = tokenArrayBegin;
+    expect_ = expectElement;
+    first_ = true;
+    return true;
+  case Reader::tokenString:
+    type_ = tokenString;
+    break;
+  case Reader::tokenNumber:
+    type_ = tokenNumber;
+    break;
+  case Reader::tokenTrue:
+    type_ = tokenTrue;
+    break;
+  case Reader::tokenFalse:
+    type_ = tokenFalse;
+    break;
+  case Reader::tokenNull:
+    type_ = tokenNull;
+    break;
+  case Reader::tokenArraySeparator:
+    if (reader_.policy_.allowDroppedNullPlaceholders()) {
+      // As in Reader, the ',' is also the separator after the dropped null.
+      type_ = tokenNull;
+      pending_ = true;
+      break;
+    }
+    // fall through
+  default:
+    return fail("Syntax error: value, object or array expected.");
+  }
+  endValue();
+  return true;
+}
+
+bool JsonCursor::endContainer(TokenType type) {
+  stack_.pop_back();
+  type_ = type;
+  endValue();
+  return true;
+}
+
+void JsonCursor::endValue() {
+  expect_ = stack_.empty() ? expectEnd : expectSeparator;
+}
+
+bool JsonCursor::fail(const char* message) {
+  reader_.addError(message);
+  type_ = tokenError;
+  return false;
+}
+
+JsonCursor::TokenType JsonCursor::type() const { return type_; }
+
+unsigned JsonCursor::depth() const {
+  unsigned depth = static_cast<unsigned>(stack_.size());
+  if (type_ == tokenObjectBegin || type_ == tokenArrayBegin)
+    --depth;
+  return depth;
+}
+
+bool JsonCursor::skipValue() {
+  if (type_ == tokenKey && !next())
+    return false;
+  if (type_ != tokenObjectBegin && type_ != tokenArrayBegin)
+    return type_ != tokenError;
+  size_t depth = stack_.size();
+  while (stack_.size() >= depth)
+    if (!next())
+      return false;
+  return true;
+}
+
+bool JsonCursor::getString(std::string& value) {
+  if (type_ != tokenKey && type_ != tokenString)
+    return false;
+  if (reader_.token_.type_ == Reader::tokenNumber) {
+    // numeric member name
+    Value number;
+    if (!reader_.decodeNumber(number)) {
+      type_ = tokenError;
+      return false;
+    }
+    value = number.asString();
+    return true;
+  }
+  if (!reader_.decodeString(value)) {
+    type_ = tokenError;
+    return false;
+  }
+  return true;
+}
+
+bool JsonCursor::getValue(Value& value) {
+  bool successful = true;
+  switch (type_) {
+  case tokenKey: {
+    std::string name;
+    successful = getString(name);
+    if (successful)
+      value = Value(name);
+  } break;
+  case tokenString:
+    successful = reader_.decodeString(value);
+    break;
+  case tokenNumber:
+    successful = reader_.decodeNumber(value);
+    break;
+  case tokenTrue:
+    Value(true).swapPayload(value);
+    break;
+  case tokenFalse:
+    Value(false).swapPayload(value);
+    break;
+  case tokenNull:
+    Value().swapPayload(value);
+    break;
+  case tokenObjectBegin:
+  case tokenArrayBegin:
+    // Reader::readValue() consumes the tokens up to the end of the container,
+    // which stack_ already holds.
+    successful = reader_.readValue(value, stack_.size() - 1);
+    if (successful)
+      return endContainer(type_ == tokenObjectBegin ? tokenObjectEnd
+                                                    : tokenArrayEnd);
+    break;
+  default:
+    return false;
+  }
+  if (!successful) {
+    type_ = tokenError;
+    return false;
+  }
+  if (reader_.storeOffsets()) {
+    value.setOffsetStart(getOffsetStart());
+    value.setOffsetLimit(getOffsetLimit());
+  }
+  return true;
+}
+
+size_t JsonCursor::getOffsetStart() const {
+  return reader_.token_.start_ - reader_.begin_;
+}
+
+size_t JsonCursor::getOffsetLimit() const {
+  return reader_.token_.end_ - reader_.begin_;
+}
+
+bool JsonCursor::good() const { return reader_.good(); }
+
+std::string JsonCursor::getFormattedErrorMessages() const {
+  return reader_.getFormattedErrorMessages();
+}
+
+std::vector<Reader::StructuredError> JsonCursor::getStructuredErrors() const {
+  return reader_.getStructuredErrors();
+}
+
+// Class IncrementalReader
+// //////////////////////////////////////////////////////////////////
+
+// Builds a Value from the parse events, used when no handler is supplied.
+class IncrementalReader::ValueBuilder : public ReaderHandler {
+public:
+  bool null() {
+    Value().swapPayload(slot());
+    return true;
+  }
+  bool boolean(bool value) {
+    Value(value).swapPayload(slot());
+    return true;
+  }
+  bool integer(LargestInt value) {
+    Value(value).swapPayload(slot());
+    return true;
+  }
+  bool unsignedInteger(LargestUInt value) {
+    Value(value).swapPayload(slot());
+    return true;
+  }
+  bool real(double value) {
+    Value(value).swapPayload(slot());
+    return true;
+  }
+  bool string(const char* begin, const char* end) {
+    Value(begin, end).swapPayload(slot());
+    return true;
+  }
+  bool startObject() { return startContainer(objectValue); }
+  bool key(const char* begin, const char* end) {
+    name_.assign(begin, end);
+    return true;
+  }
+  bool endObject() {
+    containers_.pop_back();
+    return true;
+  }
+  bool startArray() { return startContainer(arrayValue); }
+  bool endArray() {
+    containers_.pop_back();
+    return true;
+  }
+
+  void reset() {
+    Value().swap(root_);
+    containers_.clear();
+  }
+
+  Value root_;
+
+private:
+  // Returns the Value the next event is stored in.
+  Value& slot() {
+    if (containers_.empty())
+      return root_;
+    Value& container = *containers_.back();
+    if (container.type() == arrayValue)
+      return container.append(Value());
+    return container[name_];
+  }
+
+  bool startContainer(ValueType type) {
+    Value& container = slot();
+    Value(type).swapPayload(container);
+    containers_.push_back(&container);
+    return true;
+  }
+
+  std::vector<Value*> containers_;
+  std::string name_;
+};
+
+IncrementalReader::IncrementalReader()
+    : reader_(), builder_(new ValueBuilder), handler_(builder_) {
+  reset();
+}
+
+IncrementalReader::IncrementalReader(const Features& features)
+    : reader_(features), builder_(new ValueBuilder), handler_(builder_) {
+  reset();
+}
+
+IncrementalReader::IncrementalReader(ReaderHandler& handler,
+                                     const Features& features)
+    : reader_(features), builder_(0), handler_(&handler) {
+  reset();
+}
+
+IncrementalReader::~IncrementalReader() { delete builder_; }
+
+void IncrementalReader::reset() {
+  if (builder_)
+    builder_->reset();
+  reader_.errors_.clear();
+  stack_.clear();
+  pending_.resize(0);
+  errors_.clear();
+  offset_ = 0;
+  tokenOffset_ = 0;
+  literal_ = "";
+  token_ = Reader::tokenEndOfStream;
+  status_ = statusParsing;
+  expect_ = expectRoot;
+  lexeme_ = lexemeNone;
+  first_ = false;
+  marker_ = false;
+}
+
+bool IncrementalReader::feed(const char* data, size_t length) {
+  const char* current = data;
+  const char* end = data + length;
+  while (status_ == statusParsing) {
+    if (lexeme_ == lexemeNone) {
+      bool linebreak = false;
+      current = skipWhitespace(current, end, linebreak);
+      if (current == end)
+        break;
+      tokenOffset_ = offset_ + (current - data);
+    }
+    const char* begin = current;
+    if (!scanToken(current, end)) {
+      // Keep the start of the token until the next chunk completes it.
+      pending_.append(begin, end);
+      break;
+    }
+    if (pending_.empty()) {
+      processToken(begin, current);
+    } else {
+      pending_.append(begin, current);
+      processToken(pending_.data(), pending_.data() + pending_.size());
+      pending_.resize(0);
+    }
+  }
+  offset_ += length;
+  return status_ == statusParsing || status_ == statusDone;
+}
+
+bool IncrementalReader::finish() {
+  if (status_ == statusParsing && lexeme_ != lexemeNone) {
+    // Only numbers and single-line comments are ended by the end of input.
+    switch (lexeme_) {
+    case lexemeNumberIntegral:
+    case lexemeNumberFraction:
+    case lexemeNumberExponentSign:
+    case lexemeNumberExponent:
+      token_ = Reader::tokenNumber;
+      break;
+    case lexemeCppStyleComment:
+      token_ = Reader::tokenComment;
+      break;
+    default:
+      token_ = Reader::tokenError;
+      break;
+    }
+    lexeme_ = lexemeNone;
+    processToken(pending_.data(), pending_.data() + pending_.size());
+    pending_.resize(0);
+  }
+  if (status_ == statusParsing) {
+    token_ = Reader::tokenEndOfStream;
+    tokenOffset_ = offset_;
+    processToken(0, 0);
+  }
+  return status_ == statusDone;
+}
+
+bool IncrementalReader::finish(Value& root) {
+  bool successful = finish();
+  if (successful && builder_)
+    builder_->root_.swap(root);
+  else
+    Value().swap(root);
+  return successful;
+}
+
+bool IncrementalReader::scanToken(const char*& current, const char* end) {
+  if (lexeme_ == lexemeNone) {
+    token_ = Reader::tokenError;
+    switch (*current++) {
+    case '{':
+      token_ = Reader::tokenObjectBegin;
+      return true;
+    case '}':
+      token_ = Reader::tokenObjectEnd;
+      return true;
+    case '[':
+      token_ = Reader::tokenArrayBegin;
+      return true;
+    case ']':
+      token_ = Reader::tokenArrayEnd;
+      return true;
+    case ',':
+      token_ = Reader::tokenArraySeparator;
+      return true;
+    case ':':
+      token_ = Reader::tokenMemberSeparator;
+      return true;
+    case '"':
+      lexeme_ = lexemeString;
+      marker_ = false;
+      break;
+    case '/':
+      lexeme_ = lexemeCommentStart;
+      break;
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+    case '-':
+      lexeme_ = lexemeNumberIntegral;
+      break;
+    case 't':
+      token_ = Reader::tokenTrue;
+      literal_ = "rue";
+      lexeme_ = lexemeLiteral;
+      break;
+    case 'f':
+      token_ = Reader::tokenFalse;
+      literal_ = "alse";
+      lexeme_ = lexemeLiteral;
+      break;
+    case 'n':
+      token_ = Reader::tokenNull;
+      literal_ = "ull";
+      lexeme_ = lexemeLiteral;
+      break;
+    default:
+      return true;
+    }
+  }
+  for (;;) {
+    switch (lexeme_) {
+    case lexemeString:
+      for (;;) {
+        if (marker_) { // the escaped character
+          if (current == end)
+            return false;
+          ++current;
+          marker_ = false;
+        }
+        current = scanStringContent(current, end);
+        if (current == end)
+          return false;
+        Reader::Char c = *current++;
+        if (c != '\\') {
+          token_ = c == '"' ? Reader::tokenString : Reader::tokenError;
+          break;
+        }
+        marker_ = true;
+      }
+      break;
+    case lexemeNumberIntegral:
+    case lexemeNumberFraction:
+    case lexemeNumberExponent:
+      while (current != end && *current >= '0' && *current <= '9')
+        ++current;
+      if (current == end)
+        return false;
+      if (*current == '.' && lexeme_ == lexemeNumberIntegral) {
+        ++current;
+        lexeme_ = lexemeNumberFraction;
+        continue;
+      }
+      if ((*current == 'e' || *current == 'E') &&
+          lexeme_ != lexemeNumberExponent) {
+        ++current;
+        lexeme_ = lexemeNumberExponentSign;
+        continue;
+      }
+      token_ = Reader::tokenNumber;
+      break;
+    case lexemeNumberExponentSign:
+      if (current == end)
+        return false;
+      if (*current == '+' || *current == '-')
+        ++current;
+      lexeme_ = lexemeNumberExponent;
+      continue;
+    case lexemeLiteral:
+      for (; *literal_; ++literal_) {
+        if (current == end)
+          return false;
+        if (*current++ != *literal_) {
+          token_ = Reader::tokenError;
+          break;
+        }
+      }
+      break;
+    case lexemeCommentStart:
+      if (current == end)
+        return false;
+      switch (*current++) {
+      case '*':
+        lexeme_ = lexemeCStyleComment;
+        marker_ = false;
+        continue;
+      case '/':
+        lexeme_ = lexemeCppStyleComment;
+        continue;
+      }
+      token_ = Reader::tokenError;
+      break;
+    case lexemeCStyleComment:
+      for (;;) {
+        if (current == end)
+          return false;
+        Reader::Char c = *current++;
+        if (marker_ && c == '/')
+          break;
+        marker_ = c == '*';
+      }
+      token_ = Reader::tokenComment;
+      break;
+    case lexemeCppStyleComment:
+      while (current != end && *current != '\r' && *current != '\n')
+        ++current;
+      if (current == end)
+        return false;
+      token_ = Reader::tokenComment;
+      break;
+    case lexemeNone:
+      break;
+    }
+    lexeme_ = lexemeNone;
+    return true;
+  }
+}
+
+void IncrementalReader::processToken(const char* begin, const char* end) {
+  const RuntimeFeatures& features = reader_.policy_;
+  if (token_ == Reader::tokenComment && features.allowComments())
+    return;
+  switch (expect_) {
+  case expectRoot:
+    if (features.strictRoot() && token_ != Reader::tokenArrayBegin &&
+        token_ != Reader::tokenObjectBegin) {
+      fail("A valid JSON document must be either an array or an object value.",
+           end - begin);
+      return;
+    }
+    beginValue(begin, end);
+    return;
+  case expectMember:
+    if (token_ == Reader::tokenObjectEnd &&
+        (first_ || features.allowDroppedNullPlaceholders())) {
+      endContainer(); // empty object or trailing comma
+      return;
+    }
+    if (token_ == Reader::tokenString) {
+      if (!decodeString(begin, end))
+        return;
+      const std::string& name = reader_.stringBuffer_;
+      if (!emit(handler_->key(name.data(), name.data() + name.size())))
+        return;
+    } else if (token_ == Reader::tokenNumber && features.allowNumericKeys()) {
+      Value number;
+      prepareDecode(begin, end);
+      if (!reader_.decodeNumber(number)) {
+        importErrors();
+        return;
+      }
+      std::string name = number.asString();
+      if (!emit(handler_->key(name.data(), name.data() + name.size())))
+        return;
+    } else {
+      fail("Missing '}' or object member name", end - begin);
+      return;
+    }
+    first_ = false;
+    expect_ = expectMemberSeparator;
+    return;
+  case expectMemberSeparator:
+    if (token_ != Reader::tokenMemberSeparator) {
+      fail("Missing ':' after object member name", end - begin);
+      return;
+    }
+    expect_ = expectMemberValue;
+    return;
+  case expectMemberValue:
+    beginValue(begin, end);
+    return;
+  case expectElement:
+    if (token_ == Reader::tokenArrayEnd &&
+        (first_ || features.allowDroppedNullPlaceholders())) {
+      endContainer(); // empty array or trailing comma
+      return;
+    }
+    first_ = false;
+    beginValue(begin, end);
+    return;
+  case expectSeparator:
+    // first_ may still be set by a nested empty container.
+    first_ = false;
+    if (stack_.back() == '{') {
+      if (token_ == Reader::tokenObjectEnd)
+        endContainer();
+      else if (token_ == Reader::tokenArraySeparator)
+        expect_ = expectMember;
+      else
+        fail("Missing ',' or '}' in object declaration", end - begin);
+    } else {
+      if (token_ == Reader::tokenArrayEnd)
+        endContainer();
+      else if (token_ == Reader::tokenArraySeparator)
+        expect_ = expectElement;
+      else
+        fail("Missing ',' or ']' in array declaration", end - begin);
+    }
+    return;
+  case expectEnd:
+    return;
+  }
+}
+
+void IncrementalReader::beginValue(const char* begin, const char* end) {
+  if ((token_ == Reader::tokenObjectBegin ||
+       token_ == Reader::tokenArrayBegin) &&
+      stack_.size() >= reader_.policy_.maxDepth()) {
+    fail("Exceeded the maximum nesting depth.", end - begin);
+    return;
+  }
+  switch (token_) {
+  case Reader::tokenObjectBegin:
+    if (emit(handler_->startObject())) {
+      stack_.push_back('{');
+      expect_ = expectMember;
+      first_ = true;
+    }
+    return;
+  case Reader::tokenArrayBegin:
+    if (emit(handler_->startArray())) {
+      stack_.push_back('[');
+      expect_ = expectElement;
+      first_ = true;
+    }
+    return;
+  case Reader::tokenString:
+    if (decodeString(begin, end)) {
+      const std::string& value = reader_.stringBuffer_;
+      emit(handler_->string(value.data(), value.data() + value.size()));
+    }
+    break;
+  case Reader::tokenNumber:
+    prepareDecode(begin, end);
+    if (!reader_.decodeNumber(*handler_) && !importErrors())
+      emit(false);
+    break;
+  case Reader::tokenTrue:
+    emit(handler_->boolean(true));
+    break;
+  case Reader::tokenFalse:
+    emit(handler_->boolean(false));
+    break;
+  case Reader::tokenNull:
+    emit(handler_->null());
+    break;
+  case Reader::tokenArraySeparator:
+    if (reader_.policy_.allowDroppedNullPlaceholders()) {
+      // As in Reader, the ',' is also the separator after the dropped null.
+      if (emit(handler_->null())) {
+        endValue();
+        processToken(begin, end);
+      }
+      return;
+    }
+    // fall through
+  default:
+    fail("Syntax error: value, object or array expected.", end - begin);
+    return;
+  }
+  endValue();
+}
+
+void IncrementalReader::endContainer() {
+  char container = stack_.back();
+  stack_.pop_back();
+  if (emit(container == '{' ? handler_->endObject() : handler_->endArray()))
+    endValue();
+}
+
+void IncrementalReader::endValue() {
+  if (stack_.empty()) {
+    if (status_ == statusParsing)
+      status_ = statusDone;
+    expect_ = expectEnd;
+  } else {
+    expect_ = expectSeparator;
+  }
+}
+
+bool IncrementalReader::decodeString(const char* begin, const char* end) {
+  prepareDecode(begin, end);
+  if (reader_.decodeString(reader_.stringBuffer_))
+    return true;
+  importErrors();
+  return false;
+}
+
+void IncrementalReader::prepareDecode(const char* begin, const char* end) {
+  reader_.token_.type_ = token_;
+  reader_.token_.start_ = begin;
+  reader_.token_.end_ = end;
+  // Errors of the decoders are then reported relative to the token.
+  reader_.begin_ = begin;
+  reader_.end_ = end;
+}
+
+bool IncrementalReader::importErrors() {
+  if (reader_.errors_.empty())
+    return false;
+  std::vector<Reader::StructuredError> errors = reader_.getStructuredErrors();
+  for (size_t index = 0; index < errors.size(); ++index) {
+    errors[index].offset_start += tokenOffset_;
+    errors[index].offset_limit += tokenOffset_;
+    errors_.push_back(errors[index]);
+  }
+  reader_.errors_.clear();
+  status_ = statusFailed;
+  return true;
+}
+
+bool IncrementalReader::emit(bool result) {
+  if (!result)
+    status_ = statusStopped;
+  return result;
+}
+
+void IncrementalReader::fail(const char* message, size_t length) {
+  Reader::StructuredError error;
+  error.offset_start = tokenOffset_;
+  error.offset_limit = tokenOffset_ + length;
+  error.message = message;
+  errors_.push_back(error);
+  status_ = statusFailed;
+}
+
+std::string IncrementalReader::getFormattedErrorMessages() const {
+  std::string formattedMessage;
+  for (std::vector<Reader::StructuredError>::const_iterator itError =
+           errors_.begin();
+       itError != errors_.end();
+       ++itError) {
+    UIntToStringBuffer buffer;
+    char* offset = buffer + sizeof(buffer);
+    uintToString(LargestUInt(itError->offset_start), offset);
+    formattedMessage += "* Offset " + std::string(offset) + "\n";
+    formattedMessage += "  " + itError->message + "\n";
+  }
+  return formattedMessage;
+}
+
+std::vector<Reader::StructuredError>
+IncrementalReader::getStructuredErrors() const {
+  return errors_;
+}
+
+bool IncrementalReader::good() const { return errors_.empty(); }
+
+// Parallel parsing
+// //////////////////////////////////////////////////////////////////
+
+/// Parses the work item \a index of \a context with \a reader.
+typedef void (*ParseTask)(void* context, Reader& reader, size_t index);
+
+/// Returns the number of threads to use when \a threadCount are requested.
+static unsigned resolveThreadCount(unsigned threadCount) {
+#if defined(JSONCPP_HAS_THREADS)
+  if (threadCount == 0)
+    threadCount = std::thread::hardware_concurrency();
+#endif
+  return threadCount == 0 ? 1 : threadCount;
+}
+
+/** Runs \a task for every index below \a count on up to \a threadCount
+ * threads, counting the calling thread, which claim the indices in order.
+ * Each thread parses with a Reader of its own allowing \a features.
+ */
+static void runParseTasks(ParseTask task,
+                          void* context,
+                          size_t count,
+                          unsigned threadCount,
+                          const Features& features) {
+#if defined(JSONCPP_HAS_THREADS)
+  if (threadCount > count)
+    threadCount = static_cast<unsigned>(count);
+  if (threadCount > 1) {
+    std::atomic<size_t> next(0);
+    auto work = [&]() {
+      Reader reader(features);
+      for (size_t index; (index = next++) < count;)
+        task(context, reader, index);
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    try {
+      while (threads.size() + 1 < threadCount)
+        threads.push_back(std::thread(work));
+    } catch (const std::exception&) {
+      // Parse with the threads that could be started.
+    }
+    work();
+    for (size_t index = 0; index < threads.size(); ++index)
+      threads[index].join();
+    return;
+  }
+#else
+  (void)threadCount;
+#endif
+  Reader reader(features);
+  for (size_t index = 0; index < count; ++index)
+    task(context, reader, index);
+}
+
+// Class LinesReader
+// //////////////////////////////////////////////////////////////////
+
+// A run of whole lines of the input, parsed by one thread.
+class LinesReader::Block {
+public:
+  Block(const char* begin, const char* end, size_t offset)
+      : begin_(begin), end_(end), offset_(offset), lineCount_(0) {}
+
+  const char* begin_;
+  const char* end_;
+  /// Offset of begin_ in the input.
+  size_t offset_;
+  /// Records are not moved as more are added, as a Value copy is deep.
+  std::deque<Value> records_;
+  /// Errors, with record and line counted from the start of the block.
+  std::vector<StructuredError> errors_;
+  size_t lineCount_;
+};
+
+static bool isBlankLine(const char* current, const char* end) {
+  for (; current != end; ++current)
+    if (*current != ' ' && *current != '\t' && *current != '\r')
+      return false;
+  return true;
+}
+
+LinesReader::LinesReader(const Features& features, unsigned threadCount)
+    : features_(features), threadCount_(threadCount), errors_() {}
+
+bool LinesReader::parse(const char* beginDoc,
+                        const char* endDoc,
+                        std::vector<Value>& records) {
+  errors_.clear();
+  records.clear();
+  const unsigned threadCount = resolveThreadCount(threadCount_);
+
+  // Several blocks per thread balance the work when the lines of some blocks
+  // are slower to parse, without making the blocks so small that claiming
+  // them costs more than parsing them.
+  const size_t size = endDoc - beginDoc;
+  const size_t blockSize = std::max(size / (threadCount * 8), size_t(1) << 18);
+  std::vector<Block> blocks;
+  blocks.reserve(size / blockSize + 1);
+  for (const char* current = beginDoc; current != endDoc;) {
+    const char* end = current + std::min(blockSize, size_t(endDoc - current));
+    const char* newline = static_cast<const char*>(
+        memchr(end - 1, '\n', endDoc - (end - 1)));
+    end = newline ? newline + 1 : endDoc;
+    blocks.push_back(Block(current, end, current - beginDoc));
+    current = end;
+  }
+  runParseTasks(&parseBlock, &blocks, blocks.size(), threadCount, features_);
+
+  size_t recordCount = 0;
+  for (std::vector<Block>::const_iterator block = blocks.begin();
+       block != blocks.end();
+       ++block)
+    recordCount += block->records_.size();
+  records.resize(recordCount);
+  size_t record = 0;
+  size_t line = 1;
+  for (std::vector<Block>::iterator block = blocks.begin();
+       block != blocks.end();
+       ++block) {
+    for (std::vector<StructuredError>::iterator error = block->errors_.begin();
+         error != block->errors_.end();
+         ++error) {
+      error->record += record;
+      error->line += line;
+      errors_.push_back(*error);
+    }
+    for (std::deque<Value>::iterator value = block->records_.begin();
+         value != block->records_.end();
+         ++value)
+      records[record++].swap(*value);
+    line += block->lineCount_;
+  }
+  return errors_.empty();
+}
+
+bool LinesReader::parseFile(const std::string& path,
+                            std::vector<Value>& records) {
+  MappedDocument document;
+  if (!document.open(path)) {
+    records.clear();
+    errors_.clear();
+    StructuredError error;
+    error.record = 0;
+    error.line = 0;
+    error.offset_start = 0;
+    error.offset_limit = 0;
+    error.message = "Unable to map file '" + path + "'.";
+    errors_.push_back(error);
+    return false;
+  }
+  return parse(document.begin(), document.end(), records);
+}
+
+void LinesReader::parseBlock(void* blocks, Reader& reader, size_t index) {
+  Block& block = (*static_cast<std::vector<Block>*>(blocks))[index];
+  size_t line = 0;
+  for (const char* current = block.begin_; current != block.end_; ++line) {
+    const char* end = static_cast<const char*>(
+        memchr(current, '\n', block.end_ - current));
+    const char* next = end ? end + 1 : block.end_;
+    if (!end)
+      end = block.end_;
+    if (!isBlankLine(current, end)) {
+      block.records_.push_back(Value());
+      Value& record = block.records_.back();
+      if (!reader.parse(current, end, record, false)) {
+        Value().swap(record);
+        const size_t offset = block.offset_ + (current - block.begin_);
+        std::vector<Reader::StructuredError> errors =
+            reader.getStructuredErrors();
+        for (std::vector<Reader::StructuredError>::const_iterator it =
+                 errors.begin();
+             it != errors.end();
+             ++it) {
+          StructuredError error;
+          error.record = block.records_.size() - 1;
+          error.line = line;
+          error.offset_start = offset + it->offset_start;
+          error.offset_limit = offset + it->offset_limit;
+          error.message = it->message;
+          block.errors_.push_back(error);
+        }
+      }
+    }
+    current = next;
+  }
+  block.lineCount_ = line;
+}
+
+std::string LinesReader::getFormattedErrorMessages() const {
+  std::string formattedMessage;
+  for (std::vector<StructuredError>::const_iterator itError = errors_.begin();
+       itError != errors_.end();
+       ++itError) {
+    if (itError->line != 0) {
+      UIntToStringBuffer lineBuffer;
+      char* line = lineBuffer + sizeof(lineBuffer);
+      uintToString(LargestUInt(itError->line), line);
+      UIntToStringBuffer offsetBuffer;
+      char* offset = offsetBuffer + sizeof(offsetBuffer);
+      uintToString(LargestUInt(itError->offset_start), offset);
+      formattedMessage += "* Line " + std::string(line) + ", Offset " +
+                          std::string(offset) + "\n  ";
+    } else {
+      formattedMessage += "* ";
+    }
+    formattedMessage += itError->message + "\n";
+  }
+  return formattedMessage;
+}
+
+std::vector<LinesReader::StructuredError>
+LinesReader::getStructuredErrors() const {
+  return errors_;
+}
+
+bool LinesReader::good() const { return errors_.empty(); }
+
+// Class ParallelReader
+// //////////////////////////////////////////////////////////////////
+
+// A run of elements of the root array, parsed by one thread.
+class ParallelReader::Block {
+public:
+  Block(const char* begin, const char* end, ArrayIndex count)
+      : document_(), begin_(begin), end_(end), first_(), count_(count),
+        parsed_(false) {}
+
+  const char* document_;
+  /// Start of the first element.
+  const char* begin_;
+  /// Separator or ']' that follows the last element.
+  const char* end_;
+  Value::iterator first_;
+  ArrayIndex count_;
+  bool parsed_;
+};
+
+// Below this size, the first pass and the threads cost more than they gain.
+static const size_t parallelBlockSize = 1 << 18;
+
+ParallelReader::ParallelReader(const Features& features, unsigned threadCount)
+    : reader_(features), features_(features), threadCount_(threadCount) {}
+
+bool ParallelReader::parse(const char* beginDoc,
+                           const char* endDoc,
+                           Value& root) {
+  if (parseInParallel(beginDoc, endDoc, root)) {
+    reader_.errors_.clear();
+    return true;
+  }
+  return reader_.parse(beginDoc, endDoc, root, false);
+}
+
+bool ParallelReader::parseInParallel(const char* beginDoc,
+                                     const char* endDoc,
+                                     Value& root) {
+  const unsigned threadCount = resolveThreadCount(threadCount_);
+  if (threadCount < 2 || size_t(endDoc - beginDoc) < 2 * parallelBlockSize ||
+      features_.maxDepth_ == 0)
+    return false;
+
+  // Find the elements of the root array, giving up on anything that Reader
+  // would not parse the same way when the elements are parsed apart.
+  const bool allowComments = features_.allowComments_;
+  std::vector<Block> blocks;
+  const char* open = 0;
+  const char* blockBegin = 0;
+  ArrayIndex count = 0;
+  ArrayIndex total = 0;
+  size_t depth = 0;
+  bool blank = true;
+  const char* current = beginDoc;
+  for (;;) {
+    if (current == endDoc)
+      return false;
+    const Reader::Char c = *current++;
+    switch (c) {
+    case ' ':
+    case '\t':
+    case '\r':
+    case '\n':
+      break;
+    case '/':
+      if (!allowComments || current == endDoc)
+        return false;
+      if (*current == '*') {
+        Reader::Char previous = '\0';
+        for (++current;;) {
+          if (current == endDoc)
+            return false;
+          const Reader::Char next = *current++;
+          if (previous == '*' && next == '/')
+            break;
+          previous = next;
+        }
+      } else if (*current == '/') {
+        while (current != endDoc && *current != '\r' && *current != '\n')
+          ++current;
+      } else {
+        return false;
+      }
+      break;
+    case '"':
+      if (depth == 0)
+        return false;
+      for (;;) {
+        current = scanStringContent(current, endDoc);
+        if (current == endDoc || *current == '\0')
+          return false;
+        if (*current++ == '"')
+          break;
+        if (current++ == endDoc)
+          return false;
+      }
+      blank = false;
+      break;
+    case '[':
+    case '{':
+      if (depth++ == 0) {
+        if (c != '[')
+          return false;
+        open = current - 1;
+        blockBegin = current;
+      } else {
+        blank = false;
+      }
+      break;
+    case ']':
+    case '}':
+      if (depth == 0)
+        return false;
+      if (--depth == 0) {
+        if (c != ']' || blank)
+          return false; // empty array or trailing comma
+        blocks.push_back(Block(blockBegin, current - 1, ++count));
+        total += count;
+        goto scanned;
+      }
+      blank = false;
+      break;
+    case ',':
+      if (depth == 0)
+        return false;
+      if (depth == 1) {
+        if (blank)
+          return false; // dropped null placeholder
+        blank = true;
+        ++count;
+        if (size_t(current - blockBegin) >= parallelBlockSize) {
+          blocks.push_back(Block(blockBegin, current - 1, count));
+          total += count;
+          blockBegin = current;
+          count = 0;
+        }
+      }
+      break;
+    case '\0':
+      return false;
+    default:
+      if (depth == 0)
+        return false;
+      blank = false;
+      break;
+    }
+  }
+
+scanned:
+  // Add the elements sequentially: inserting into an array is not thread
+  // safe, but filling distinct elements is.
+  Value(arrayValue).swapPayload(root);
+  if (features_.storeOffsets_) {
+    root.setOffsetStart(open - beginDoc);
+    root.setOffsetLimit(current - beginDoc);
+  }
+  for (ArrayIndex index = 0; index < total; ++index)
+    root[index];
+  Value::iterator element = root.begin();
+  for (std::vector<Block>::iterator block = blocks.begin();
+       block != blocks.end();
+       ++block) {
+    block->document_ = beginDoc;
+    block->first_ = element;
+    for (ArrayIndex index = 0; index < block->count_; ++index)
+      ++element;
+  }
+
+  // The root array is one level deep already.
+  Features elementFeatures = features_;
+  --elementFeatures.maxDepth_;
+  runParseTasks(
+      &parseBlock, &blocks, blocks.size(), threadCount, elementFeatures);
+  for (std::vector<Block>::const_iterator block = blocks.begin();
+       block != blocks.end();
+       ++block)
+    if (!block->parsed_)
+      return false;
+  return true;
+}
+
+void ParallelReader::parseBlock(void* blocks, Reader& reader, size_t index) {
+  Block& block = (*static_cast<std::vector<Block>*>(blocks))[index];
+  reader.begin_ = block.document_;
+  reader.end_ = block.end_;
+  reader.current_ = block.begin_;
+  reader.collectComments_ = false;
+  reader.inSitu_ = false;
+  reader.errors_.clear();
+  Value::iterator element = block.first_;
+  for (ArrayIndex index = 0; index < block.count_; ++index, ++element) {
+    reader.skipCommentTokens();
+    if (!reader.readValue(*element))
+      return;
+    reader.skipCommentTokens();
+    if (reader.token_.type_ != (index + 1 == block.count_
+                                    ? Reader::tokenEndOfStream
+                                    : Reader::tokenArraySeparator))
+      return;
+  }
+  block.parsed_ = true;
+}
+
+std::string ParallelReader::getFormattedErrorMessages() const {
+  return reader_.getFormattedErrorMessages();
+}
+
+std::vector<Reader::StructuredError>
+ParallelReader::getStructuredErrors() const {
+  return reader_.getStructuredErrors();
+}
+
+bool ParallelReader::good() const { return reader_.good(); }
+
+// Class LazyValue
+// //////////////////////////////////////////////////////////////////
+
+LazyValue::const_iterator::const_iterator() : document_(0), element_(0) {}
+
+LazyValue::const_iterator::const_iterator(const LazyDocument* document,
+                                          size_t element)
+    : document_(document), element_(element) {}
+
+LazyValue LazyValue::const_iterator::operator*() const {
+  const LazyDocument::Element& element = document_->elements_[element_];
+  return LazyValue(document_, element.start_, element.limit_, element.node_);
+}
+
+LazyValue::const_iterator& LazyValue::const_iterator::operator++() {
+  ++element_;
+  return *this;
+}
+
+bool LazyValue::const_iterator::operator==(const const_iterator& other) const {
+  return document_ == other.document_ && element_ == other.element_;
+}
+
+bool LazyValue::const_iterator::operator!=(const const_iterator& other) const {
+  return !(*this == other);
+}
+
+std::string LazyValue::const_iterator::name() const {
+  return document_->keyName(document_->elements_[element_]);
+}
+
+LazyValue::LazyValue() : document_(0), start_(0), limit_(0), node_(0) {}
+
+LazyValue::LazyValue(const LazyDocument* document,
+                     size_t start,
+                     size_t limit,
+                     size_t node)
+    : document_(document), start_(start), limit_(limit), node_(node) {}
+
+ValueType LazyValue::type() const {
+  if (!document_)
+    return nullValue;
+  if (node_ != LazyDocument::npos)
+    return document_->nodes_[node_].type_;
+  return document_->scalarType(start_, limit_);
+}
+
+ArrayIndex LazyValue::size() const {
+  if (!document_ || node_ == LazyDocument::npos)
+    return 0;
+  return document_->findElements(node_).size_;
+}
+
+bool LazyValue::isMember(const std::string& key) const {
+  return member(key.data(), key.size()).document_ != 0;
+}
+
+LazyValue LazyValue::operator[](const std::string& key) const {
+  return member(key.data(), key.size());
+}
+
+LazyValue LazyValue::operator[](const char* key) const {
+  return member(key, strlen(key));
+}
+
+LazyValue LazyValue::operator[](ArrayIndex index) const {
+  if (type() != arrayValue)
+    return LazyValue();
+  const LazyDocument::Node& node = document_->findElements(node_);
+  if (index >= node.size_)
+    return LazyValue();
+  const LazyDocument::Element& element =
+      document_->elements_[node.elements_ + index];
+  return LazyValue(document_, element.start_, element.limit_, element.node_);
+}
+
+LazyValue LazyValue::operator[](int index) const {
+  if (index < 0)
+    return LazyValue();
+  return (*this)[ArrayIndex(index)];
+}
+
+LazyValue LazyValue::member(const char* key, size_t length) const {
+  if (type() != objectValue)
+    return LazyValue();
+  const LazyDocument::Node& node = document_->findElements(node_);
+  // Searches from the end, as the last duplicate wins in Value.
+  for (size_t index = node.elements_ + node.size_; index != node.elements_;) {
+    const LazyDocument::Element& element = document_->elements_[--index];
+    if (document_->keyEquals(element, key, length))
+      return LazyValue(
+          document_, element.start_, element.limit_, element.node_);
+  }
+  return LazyValue();
+}
+
+LazyValue::const_iterator LazyValue::begin() const {
+  if (size() == 0)
+    return const_iterator();
+  return const_iterator(document_, document_->nodes_[node_].elements_);
+}
+
+LazyValue::const_iterator LazyValue::end() const {
+  if (size() == 0)
+    return const_iterator();
+  const LazyDocument::Node& node = document_->nodes_[node_];
+  return const_iterator(document_, node.elements_ + node.size_);
+}
+
+Value::Members LazyValue::getMemberNames() const {
+  Value::Members members;
+  if (type() != objectValue)
+    return members;
+  members.reserve(size());
+  for (const_iterator it = begin(); it != end(); ++it)
+    members.push_back(it.name());
+  return members;
+}
+
+const Value& LazyValue::value() const {
+  return document_ ? document_->materialize(start_, limit_) : Value::null;
+}
+
+size_t LazyValue::getOffsetStart() const { return start_; }
+
+size_t LazyValue::getOffsetLimit() const { return limit_; }
+
+// Class LazyDocument
+// //////////////////////////////////////////////////////////////////
+
+const ArrayIndex LazyDocument::unknownSize = ArrayIndex(-1);
+const size_t LazyDocument::npos = size_t(-1);
+
+// Records the arrays and objects of the document in its index as they are
+// validated.
+class LazyDocument::Indexer : public ReaderHandler {
+public:
+  Indexer(LazyDocument& document) : document_(document) {}
+
+  virtual bool startObject() {
+    document_.beginNode(objectValue);
+    return true;
+  }
+  virtual bool endObject() {
+    document_.endNode();
+    return true;
+  }
+
+  virtual bool startArray() {
+    document_.beginNode(arrayValue);
+    return true;
+  }
+  virtual bool endArray() {
+    document_.endNode();
+    return true;
+  }
+
+private:
+  Indexer(const Indexer&);
+  Indexer& operator=(const Indexer&);
+
+  LazyDocument& document_;
+};
+
+LazyDocument::LazyDocument()
+    : reader_(), document_(), nodes_(), open_(), elements_(), root_(),
+      parsed_(false), values_() {}
+
+LazyDocument::LazyDocument(const Features& features)
+    : reader_(features), document_(), nodes_(), open_(), elements_(),
+      root_(), parsed_(false), values_() {}
+
+bool LazyDocument::parse(const char* beginDoc, const char* endDoc) {
+  nodes_.clear();
+  open_.clear();
+  elements_.clear();
+  values_.clear();
+  parsed_ = false;
+  Indexer indexer(*this);
+  if (!reader_.readDocument(beginDoc, endDoc, indexer, false)) {
+    nodes_.clear();
+    return false;
+  }
+  // The root is the first array or object, or else a single scalar.
+  reader_.current_ = reader_.begin_;
+  reader_.skipCommentTokens();
+  root_.start_ = reader_.token_.start_ - reader_.begin_;
+  root_.keyStart_ = 0;
+  root_.keyLimit_ = 0;
+  if (nodes_.empty()) {
+    root_.limit_ = reader_.token_.end_ - reader_.begin_;
+    root_.node_ = npos;
+  } else {
+    root_.limit_ = nodes_[0].limit_;
+    root_.node_ = 0;
+  }
+  parsed_ = true;
+  return true;
+}
+
+bool LazyDocument::parse(const std::string& document) {
+  document_ = document;
+  const char* begin = document_.data();
+  return parse(begin, begin + document_.size());
+}
+
+LazyValue LazyDocument::root() const {
+  if (!parsed_)
+    return LazyValue();
+  return LazyValue(this, root_.start_, root_.limit_, root_.node_);
+}
+
+void LazyDocument::beginNode(ValueType type) {
+  Node node;
+  node.type_ = type;
+  node.size_ = unknownSize;
+  node.start_ = reader_.token_.start_ - reader_.begin_;
+  node.limit_ = 0;
+  node.next_ = 0;
+  node.elements_ = 0;
+  open_.push_back(nodes_.size());
+  nodes_.push_back(node);
+}
+
+void LazyDocument::endNode() {
+  Node& node = nodes_[open_.back()];
+  open_.pop_back();
+  node.limit_ = reader_.token_.end_ - reader_.begin_;
+  node.next_ = nodes_.size();
+}
+
+// Reads the tokens of the node once to record where its elements start,
+// stepping over the nested arrays and objects with their recorded limits.
+const LazyDocument::Node& LazyDocument::findElements(size_t index) const {
+  Node& node = nodes_[index];
+  if (node.size_ != unknownSize)
+    return node;
+  const Reader::Location begin = reader_.begin_;
+  const Reader::TokenType endToken = node.type_ == objectValue
+                                         ? Reader::tokenObjectEnd
+                                         : Reader::tokenArrayEnd;
+  size_t nested = index + 1;
+  node.elements_ = elements_.size();
+  reader_.current_ = begin + node.start_ + 1;
+  reader_.skipCommentTokens();
+  while (reader_.token_.type_ != endToken) {
+    Element element;
+    element.keyStart_ = 0;
+    element.keyLimit_ = 0;
+    if (node.type_ == objectValue) {
+      element.keyStart_ = reader_.token_.start_ - begin;
+      element.keyLimit_ = reader_.token_.end_ - begin;
+      reader_.skipCommentTokens(); // ':'
+      reader_.skipCommentTokens();
+    }
+    element.start_ = reader_.token_.start_ - begin;
+    element.limit_ = reader_.token_.end_ - begin;
+    element.node_ = npos;
+    if (reader_.token_.type_ == Reader::tokenArrayBegin ||
+        reader_.token_.type_ == Reader::tokenObjectBegin) {
+      element.node_ = nested;
+      element.limit_ = nodes_[nested].limit_;
+      nested = nodes_[nested].next_;
+      reader_.current_ = begin + element.limit_;
+    }
+    elements_.push_back(element);
+    // A dropped null is its own separator, as in Reader.
+    if (reader_.token_.type_ != Reader::tokenArraySeparator)
+      reader_.skipCommentTokens();
+    if (reader_.token_.type_ == Reader::tokenArraySeparator)
+      reader_.skipCommentTokens();
+  }
+  node.size_ = ArrayIndex(elements_.size() - node.elements_);
+  return node;
+}
+
+ValueType LazyDocument::scalarType(size_t start, size_t limit) const {
+  switch (reader_.begin_[start]) {
+  case '"':
+    return stringValue;
+  case 't':
+  case 'f':
+    return booleanValue;
+  case 'n':
+  case ',': // dropped null
+    return nullValue;
+  default:
+    return materialize(start, limit).type();
+  }
+}
+
+std::string LazyDocument::keyName(const Element& element) const {
+  if (element.keyStart_ == element.keyLimit_)
+    return std::string();
+  reader_.token_.start_ = reader_.begin_ + element.keyStart_;
+  reader_.token_.end_ = reader_.begin_ + element.keyLimit_;
+  std::string name;
+  if (*reader_.token_.start_ == '"') {
+    reader_.decodeString(name);
+  } else {
+    Value number;
+    reader_.decodeNumber(number);
+    name = number.asString();
+  }
+  return name;
+}
+
+// Compares the name as written, unless it must be decoded.
+bool LazyDocument::keyEquals(const Element& element,
+                             const char* key,
+                             size_t length) const {
+  const char* name = reader_.begin_ + element.keyStart_;
+  const char* end = reader_.begin_ + element.keyLimit_;
+  if (name == end)
+    return false;
+  if (*name == '"' && std::find(name + 1, end - 1, '\\') == end - 1)
+    return size_t(end - name - 2) == length &&
+           memcmp(name + 1, key, length) == 0;
+  const std::string decoded = keyName(element);
+  return decoded.size() == length && memcmp(decoded.data(), key, length) == 0;
+}
+
+const Value& LazyDocument::materialize(size_t start, size_t limit) const {
+  if (reader_.begin_[start] == ',') // dropped null
+    return Value::null;
+  Values::iterator it = values_.find(start);
+  if (it != values_.end())
+    return it->second;
+  Value& value = values_[start];
+  // The document is valid: parse the range of the value again.
+  const Reader::Location end = reader_.end_;
+  reader_.current_ = reader_.begin_ + start;
+  reader_.end_ = reader_.begin_ + limit;
+  reader_.collectComments_ = false;
+  reader_.inSitu_ = false;
+  reader_.skipCommentTokens();
+  reader_.readValue(value);
+  reader_.end_ = end;
+  return value;
+}
+
+std::string LazyDocument::getFormattedErrorMessages() const {
+  return reader_.getFormattedErrorMessages();
+}
+
+std::vector<Reader::StructuredError>
+LazyDocument::getStructuredErrors() const {
+  return reader_.getStructuredErrors();
+}
+
+bool LazyDocument::good() const { return reader_.good(); }
+
 std::istream& operator>>(std::istream& sin, Value& root) {
   Json::Reader reader;
   bool ok = reader.parse(sin, root, true);
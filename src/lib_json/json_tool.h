@@ -14,33 +14,42 @@
 
 namespace Json {
 
-/// Converts a unicode code-point to UTF-8.
-static inline std::string codePointToUTF8(unsigned int cp) {
-  std::string result;
-
+/** Converts a unicode code-point to UTF-8.
+ * @param out Buffer of at least 4 chars receiving the UTF-8 sequence.
+ * @return Number of chars written, 0 if \a cp is out of range.
+ */
+static inline unsigned encodeUTF8(unsigned int cp, char* out) {
   // based on description from http://en.wikipedia.org/wiki/UTF-8
 
   if (cp <= 0x7f) {
-    result.resize(1);
-    result[0] = static_cast<char>(cp);
-  } else if (cp <= 0x7FF) {
-    result.resize(2);
-    result[1] = static_cast<char>(0x80 | (0x3f & cp));
-    result[0] = static_cast<char>(0xC0 | (0x1f & (cp >> 6)));
-  } else if (cp <= 0xFFFF) {
-    result.resize(3);
-    result[2] = static_cast<char>(0x80 | (0x3f & cp));
-    result[1] = 0x80 | static_cast<char>((0x3f & (cp >> 6)));
-    result[0] = 0xE0 | static_cast<char>((0xf & (cp >> 12)));
-  } else if (cp <= 0x10FFFF) {
-    result.resize(4);
-    result[3] = static_cast<char>(0x80 | (0x3f & cp));
-    result[2] = static_cast<char>(0x80 | (0x3f & (cp >> 6)));
-    result[1] = static_cast<char>(0x80 | (0x3f & (cp >> 12)));
-    result[0] = static_cast<char>(0xF0 | (0x7 & (cp >> 18)));
+    out[0] = static_cast<char>(cp);
+    return 1;
+  }
+  if (cp <= 0x7FF) {
+    out[1] = static_cast<char>(0x80 | (0x3f & cp));
+    out[0] = static_cast<char>(0xC0 | (0x1f & (cp >> 6)));
+    return 2;
   }
+  if (cp <= 0xFFFF) {
+    out[2] = static_cast<char>(0x80 | (0x3f & cp));
+    out[1] = static_cast<char>(0x80 | (0x3f & (cp >> 6)));
+    out[0] = static_cast<char>(0xE0 | (0xf & (cp >> 12)));
+    return 3;
+  }
+  if (cp <= 0x10FFFF) {
+    out[3] = static_cast<char>(0x80 | (0x3f & cp));
+    out[2] = static_cast<char>(0x80 | (0x3f & (cp >> 6)));
+    out[1] = static_cast<char>(0x80 | (0x3f & (cp >> 12)));
+    out[0] = static_cast<char>(0xF0 | (0x7 & (cp >> 18)));
+    return 4;
+  }
+  return 0;
+}
 
-  return result;
+/// Converts a unicode code-point to UTF-8.
+static inline std::string codePointToUTF8(unsigned int cp) {
+  char buffer[4];
+  return std::string(buffer, encodeUTF8(cp, buffer));
 }
 
 /// Returns true if ch is a control character (in range [0,32[).
@@ -12,6 +12,7 @@
 #endif // #ifndef JSON_USE_SIMPLE_INTERNAL_ALLOCATOR
 #endif // if !defined(JSON_IS_AMALGAMATION)
 #include <math.h>
+#include <algorithm>
 #include <sstream>
 #include <utility>
 #include <cstring>
@@ -106,6 +107,24 @@ static inline char* duplicateStringValue(const char* value,
  */
 static inline void releaseStringValue(char* value) { free(value); }
 
+#ifndef JSON_VALUE_USE_INTERNAL_MAP
+/** Resize an array to \a size elements, appending null values.
+ * When the array outgrows its storage, its elements are swapped into a
+ * storage twice as large rather than copied with their whole tree.
+ */
+static void resizeArray(Value::ArrayValues& array, ArrayIndex size) {
+  if (size > array.capacity()) {
+    Value::ArrayValues grown;
+    grown.reserve(std::max<size_t>(size, 2 * array.capacity()));
+    grown.resize(array.size());
+    for (size_t index = 0; index < array.size(); ++index)
+      grown[index].swap(array[index]);
+    array.swap(grown);
+  }
+  array.resize(size);
+}
+#endif
+
 } // namespace Json
 
 // //////////////////////////////////////////////////////////////////
@@ -154,6 +173,73 @@ void Value::CommentInfo::setComment(const char* text) {
   comment_ = duplicateStringValue(text);
 }
 
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class KeyTable
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+// FNV-1a
+static unsigned hashKey(const char* begin, const char* end) {
+  unsigned hash = 2166136261u;
+  for (; begin != end; ++begin)
+    hash = (hash ^ static_cast<unsigned char>(*begin)) * 16777619u;
+  return hash;
+}
+
+KeyTable::KeyTable() : size_(0) {}
+
+KeyTable::~KeyTable() {
+  for (std::vector<Key>::iterator it = keys_.begin(); it != keys_.end(); ++it)
+    if (it->string_)
+      releaseStringValue(const_cast<char*>(it->string_));
+}
+
+const char* KeyTable::intern(const char* key) {
+  return intern(key, key + strlen(key));
+}
+
+const char* KeyTable::intern(const char* begin, const char* end) {
+  // Kept at most half full, so that probing stays short.
+  if (2 * (size_ + 1) > keys_.size())
+    grow();
+  const unsigned length = unsigned(end - begin);
+  const unsigned hash = hashKey(begin, end);
+  const size_t mask = keys_.size() - 1;
+  for (size_t index = hash & mask;; index = (index + 1) & mask) {
+    Key& key = keys_[index];
+    if (key.string_ == 0) {
+      key.string_ = duplicateStringValue(begin, length);
+      key.length_ = length;
+      key.hash_ = hash;
+      ++size_;
+      return key.string_;
+    }
+    if (key.hash_ == hash && key.length_ == length &&
+        memcmp(key.string_, begin, length) == 0)
+      return key.string_;
+  }
+}
+
+size_t KeyTable::size() const { return size_; }
+
+void KeyTable::grow() {
+  Key empty = { 0, 0, 0 };
+  std::vector<Key> keys(std::max<size_t>(16, 2 * keys_.size()), empty);
+  const size_t mask = keys.size() - 1;
+  for (std::vector<Key>::iterator it = keys_.begin(); it != keys_.end(); ++it) {
+    if (it->string_ == 0)
+      continue;
+    size_t index = it->hash_ & mask;
+    while (keys[index].string_)
+      index = (index + 1) & mask;
+    keys[index] = *it;
+  }
+  keys_.swap(keys);
+}
+
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
@@ -166,20 +252,24 @@ void Value::CommentInfo::setComment(const char* text) {
 // Notes: index_ indicates if the string was allocated when
 // a string is stored.
 
-Value::CZString::CZString(ArrayIndex index) : cstr_(0), index_(index) {}
+Value::CZString::CZString(ArrayIndex index)
+    : cstr_(0), index_(index), length_(0) {}
 
-Value::CZString::CZString(const char* cstr, DuplicationPolicy allocate)
-    : cstr_(allocate == duplicate ? duplicateStringValue(cstr) : cstr),
-      index_(allocate) {}
+Value::CZString::CZString(const char* cstr,
+                          unsigned length,
+                          DuplicationPolicy allocate)
+    : cstr_(allocate == duplicate ? duplicateStringValue(cstr, length) : cstr),
+      index_(allocate), length_(length) {}
 
 Value::CZString::CZString(const CZString& other)
     : cstr_(other.index_ != noDuplication && other.cstr_ != 0
-                ? duplicateStringValue(other.cstr_)
+                ? duplicateStringValue(other.cstr_, other.length_)
                 : other.cstr_),
       index_(other.cstr_
                  ? static_cast<ArrayIndex>(other.index_ == noDuplication
                      ? noDuplication : duplicate)
-                 : other.index_) {}
+                 : other.index_),
+      length_(other.length_) {}
 
 Value::CZString::~CZString() {
   if (cstr_ && index_ == duplicate)
@@ -189,6 +279,7 @@ Value::CZString::~CZString() {
 void Value::CZString::swap(CZString& other) {
   std::swap(cstr_, other.cstr_);
   std::swap(index_, other.index_);
+  std::swap(length_, other.length_);
 }
 
 Value::CZString& Value::CZString::operator=(CZString other) {
@@ -196,13 +287,20 @@ Value::CZString& Value::CZString::operator=(CZString other) {
   return *this;
 }
 
-static int natcmp(const char *p, const char *q) {
+// The character at \a index of a string of \a length characters, or '\0' past
+// its end.
+static inline char charAt(const char* p, unsigned length, int index) {
+  return unsigned(index) < length ? p[index] : '\0';
+}
+
+static int natcmp(const char *p, unsigned pLength,
+                  const char *q, unsigned qLength) {
   char a, b;
   do {
     int i = 0, j = 0;
     // advance indexes on either side beyond first non-digit
-    do a = p[i++]; while (a >= '0' && a <= '9');
-    do b = q[j++]; while (b >= '0' && b <= '9');
+    do a = charAt(p, pLength, i++); while (a >= '0' && a <= '9');
+    do b = charAt(q, qLength, j++); while (b >= '0' && b <= '9');
     if (i != 1 || j != 1) {
       // at least one side is numeric
       if (i == 1) {
@@ -222,20 +320,31 @@ static int natcmp(const char *p, const char *q) {
       }
     }
     p += i;
+    pLength -= i;
     q += j;
+    qLength -= j;
   } while (a && a == b);
   return a - b;
 }
 
 bool Value::CZString::operator<(const CZString& other) const {
-  if (cstr_)
-    return natcmp(cstr_, other.cstr_) < 0;
-  return index_ < other.index_;
+  if (!cstr_)
+    return index_ < other.index_;
+  // Interned and static names are often the very same string.
+  if (cstr_ == other.cstr_ && length_ == other.length_)
+    return false;
+  if (int c = natcmp(cstr_, length_, other.cstr_, other.length_))
+    return c < 0;
+  // Names that only differ after a '\0' are ordered by their bytes.
+  if (int c = memcmp(cstr_, other.cstr_, std::min(length_, other.length_)))
+    return c < 0;
+  return length_ < other.length_;
 }
 
 bool Value::CZString::operator==(const CZString& other) const {
   if (cstr_)
-    return strcmp(cstr_, other.cstr_) == 0;
+    return length_ == other.length_ &&
+           (cstr_ == other.cstr_ || memcmp(cstr_, other.cstr_, length_) == 0);
   return index_ == other.index_;
 }
 
@@ -243,10 +352,93 @@ ArrayIndex Value::CZString::index() const { return index_; }
 
 const char* Value::CZString::c_str() const { return cstr_; }
 
+unsigned Value::CZString::length() const { return length_; }
+
 bool Value::CZString::isStaticString() const { return index_ == noDuplication; }
 
+void Value::CZString::adopt() {
+  JSON_ASSERT(cstr_ != 0 && index_ == noDuplication);
+  index_ = duplicate;
+}
+
 #endif // ifndef JSON_VALUE_USE_INTERNAL_MAP
 
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class Value::ObjectValues
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+#if defined(JSON_VALUE_USE_FLAT_MAP) && !defined(JSON_VALUE_USE_INTERNAL_MAP)
+
+static inline void swapMembers(Value::ObjectValues::value_type& a,
+                               Value::ObjectValues::value_type& b) {
+  a.first.swap(b.first);
+  a.second.swap(b.second);
+}
+
+bool Value::ObjectValues::isKeyLess(const value_type& member,
+                                    const CZString& key) {
+  return member.first < key;
+}
+
+Value::ObjectValues::iterator
+Value::ObjectValues::lower_bound(const CZString& key) {
+  return std::lower_bound(members_.begin(), members_.end(), key, &isKeyLess);
+}
+
+Value::ObjectValues::iterator Value::ObjectValues::find(const CZString& key) {
+  iterator it = lower_bound(key);
+  return it != members_.end() && (*it).first == key ? it : members_.end();
+}
+
+Value::ObjectValues::const_iterator
+Value::ObjectValues::find(const CZString& key) const {
+  const_iterator it =
+      std::lower_bound(members_.begin(), members_.end(), key, &isKeyLess);
+  return it != members_.end() && (*it).first == key ? it : members_.end();
+}
+
+Value::ObjectValues::iterator
+Value::ObjectValues::insert(iterator position, const value_type& member) {
+  const size_t index = position - members_.begin();
+  if (members_.size() == members_.capacity()) {
+    std::vector<value_type> grown;
+    grown.reserve(std::max<size_t>(4, 2 * members_.capacity()));
+    grown.resize(members_.size(), value_type(CZString(0), Value()));
+    for (size_t moved = 0; moved < members_.size(); ++moved)
+      swapMembers(grown[moved], members_[moved]);
+    members_.swap(grown);
+  }
+  members_.push_back(member);
+  for (size_t moved = members_.size() - 1; moved > index; --moved)
+    swapMembers(members_[moved], members_[moved - 1]);
+  return members_.begin() + index;
+}
+
+Value::ObjectValues::iterator Value::ObjectValues::erase(iterator position) {
+  const size_t index = position - members_.begin();
+  for (size_t moved = index + 1; moved < members_.size(); ++moved)
+    swapMembers(members_[moved - 1], members_[moved]);
+  members_.pop_back();
+  return members_.begin() + index;
+}
+
+bool Value::ObjectValues::operator<(const ObjectValues& other) const {
+  return std::lexicographical_compare(members_.begin(),
+                                      members_.end(),
+                                      other.members_.begin(),
+                                      other.members_.end());
+}
+
+bool Value::ObjectValues::operator==(const ObjectValues& other) const {
+  return members_.size() == other.members_.size() &&
+         std::equal(members_.begin(), members_.end(), other.members_.begin());
+}
+
+#endif // if defined(JSON_VALUE_USE_FLAT_MAP) && ...
+
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
@@ -276,6 +468,8 @@ Value::Value(ValueType type) {
     break;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   case arrayValue:
+    value_.array_ = new ArrayValues();
+    break;
   case objectValue:
     value_.map_ = new ObjectValues();
     break;
@@ -321,31 +515,30 @@ Value::Value(double value) {
 }
 
 Value::Value(const char* value) {
-  initBasic(stringValue, true);
-  value_.string_ = duplicateStringValue(value);
+  initBasic(stringValue);
+  initString(value, strlen(value));
 }
 
 Value::Value(const char* beginValue, const char* endValue) {
-  initBasic(stringValue, true);
-  value_.string_ =
-      duplicateStringValue(beginValue, (unsigned int)(endValue - beginValue));
+  initBasic(stringValue);
+  initString(beginValue, endValue - beginValue);
 }
 
 Value::Value(const std::string& value) {
-  initBasic(stringValue, true);
-  value_.string_ =
-      duplicateStringValue(value.c_str(), (unsigned int)value.length());
+  initBasic(stringValue);
+  initString(value.c_str(), value.length());
 }
 
 Value::Value(const StaticString& value) {
   initBasic(stringValue);
   value_.string_ = const_cast<char*>(value.c_str());
+  length_ = unsigned(strlen(value.c_str()));
 }
 
 #ifdef JSON_USE_CPPTL
 Value::Value(const CppTL::ConstString& value) {
-  initBasic(stringValue, true);
-  value_.string_ = duplicateStringValue(value, value.length());
+  initBasic(stringValue);
+  initString(value, value.length());
 }
 #endif
 
@@ -355,13 +548,18 @@ Value::Value(bool value) {
 }
 
 Value::Value(const Value& other)
-    : type_(other.type_), allocated_(false)
+    : type_(other.type_), allocated_(false), inlined_(other.inlined_)
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
       ,
       itemIsUsed_(0)
 #endif
       ,
-      comments_(0), start_(other.start_), limit_(other.limit_) {
+      length_(other.length_), comments_(0)
+#ifndef JSON_VALUE_NO_OFFSETS
+      ,
+      start_(other.start_), limit_(other.limit_)
+#endif
+{
   switch (type_) {
   case nullValue:
   case intValue:
@@ -371,16 +569,17 @@ Value::Value(const Value& other)
     value_ = other.value_;
     break;
   case stringValue:
-    if (other.value_.string_) {
-      value_.string_ = duplicateStringValue(other.value_.string_);
-      allocated_ = true;
-    } else {
+    if (other.inlined_)
+      value_ = other.value_;
+    else if (other.value_.string_)
+      initString(other.value_.string_, other.length_);
+    else
       value_.string_ = 0;
-      allocated_ = false;
-    }
     break;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   case arrayValue:
+    value_.array_ = new ArrayValues(*other.value_.array_);
+    break;
   case objectValue:
     value_.map_ = new ObjectValues(*other.value_.map_);
     break;
@@ -419,6 +618,8 @@ Value::~Value() {
     break;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   case arrayValue:
+    delete value_.array_;
+    break;
   case objectValue:
     delete value_.map_;
     break;
@@ -451,13 +652,19 @@ void Value::swapPayload(Value& other) {
   int temp2 = allocated_;
   allocated_ = other.allocated_;
   other.allocated_ = temp2;
+  temp2 = inlined_;
+  inlined_ = other.inlined_;
+  other.inlined_ = temp2;
+  std::swap(length_, other.length_);
 }
 
 void Value::swap(Value& other) {
   swapPayload(other);
   std::swap(comments_, other.comments_);
+#ifndef JSON_VALUE_NO_OFFSETS
   std::swap(start_, other.start_);
   std::swap(limit_, other.limit_);
+#endif
 }
 
 ValueType Value::type() const { return type_; }
@@ -485,12 +692,22 @@ bool Value::operator<(const Value& other) const {
     return value_.real_ < other.value_.real_;
   case booleanValue:
     return value_.bool_ < other.value_.bool_;
-  case stringValue:
-    return (value_.string_ == 0 && other.value_.string_) ||
-           (other.value_.string_ && value_.string_ &&
-            strcmp(value_.string_, other.value_.string_) < 0);
+  case stringValue: {
+    const char* string = storedString();
+    const char* otherString = other.storedString();
+    if (!string || !otherString)
+      return !string && otherString;
+    if (int c = memcmp(string, otherString, std::min(length_, other.length_)))
+      return c < 0;
+    return length_ < other.length_;
+  }
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  case arrayValue:
+  case arrayValue: {
+    int delta = int(value_.array_->size() - other.value_.array_->size());
+    if (delta)
+      return delta < 0;
+    return (*value_.array_) < (*other.value_.array_);
+  }
   case objectValue: {
     int delta = int(value_.map_->size() - other.value_.map_->size());
     if (delta)
@@ -534,12 +751,17 @@ bool Value::operator==(const Value& other) const {
     return value_.real_ == other.value_.real_;
   case booleanValue:
     return value_.bool_ == other.value_.bool_;
-  case stringValue:
-    return (value_.string_ == other.value_.string_) ||
-           (other.value_.string_ && value_.string_ &&
-            strcmp(value_.string_, other.value_.string_) == 0);
+  case stringValue: {
+    const char* string = storedString();
+    const char* otherString = other.storedString();
+    return (string == otherString) ||
+           (otherString && string && length_ == other.length_ &&
+            memcmp(string, otherString, length_) == 0);
+  }
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   case arrayValue:
+    return value_.array_->size() == other.value_.array_->size() &&
+           (*value_.array_) == (*other.value_.array_);
   case objectValue:
     return value_.map_->size() == other.value_.map_->size() &&
            (*value_.map_) == (*other.value_.map_);
@@ -560,15 +782,25 @@ bool Value::operator!=(const Value& other) const { return !(*this == other); }
 const char* Value::asCString() const {
   JSON_ASSERT_MESSAGE(type_ == stringValue,
                       "in Json::Value::asCString(): requires stringValue");
-  return value_.string_;
+  return storedString();
+}
+
+bool Value::getString(const char** begin, const char** end) const {
+  if (type_ != stringValue || storedString() == 0)
+    return false;
+  *begin = storedString();
+  *end = *begin + length_;
+  return true;
 }
 
 std::string Value::asString() const {
   switch (type_) {
   case nullValue:
     return "";
-  case stringValue:
-    return value_.string_ ? value_.string_ : "";
+  case stringValue: {
+    const char* string = storedString();
+    return string ? std::string(string, length_) : "";
+  }
   case booleanValue:
     return value_.bool_ ? "true" : "false";
   case intValue:
@@ -761,7 +993,7 @@ bool Value::isConvertibleTo(ValueType other) const {
     return (isNumeric() && asDouble() == 0.0) ||
            (type_ == booleanValue && value_.bool_ == false) ||
            (type_ == stringValue && asString() == "") ||
-           (type_ == arrayValue && value_.map_->size() == 0) ||
+           (type_ == arrayValue && size() == 0) ||
            (type_ == objectValue && value_.map_->size() == 0) ||
            type_ == nullValue;
   case intValue:
@@ -799,13 +1031,8 @@ ArrayIndex Value::size() const {
   case stringValue:
     return 0;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  case arrayValue: // size of the array is highest index + 1
-    if (!value_.map_->empty()) {
-      ObjectValues::const_iterator itLast = value_.map_->end();
-      --itLast;
-      return (*itLast).first.index() + 1;
-    }
-    return 0;
+  case arrayValue:
+    return ArrayIndex(value_.array_->size());
   case objectValue:
     return ArrayIndex(value_.map_->size());
 #else
@@ -832,11 +1059,15 @@ void Value::clear() {
   JSON_ASSERT_MESSAGE(type_ == nullValue || type_ == arrayValue ||
                           type_ == objectValue,
                       "in Json::Value::clear(): requires complex value");
+#ifndef JSON_VALUE_NO_OFFSETS
   start_ = 0;
   limit_ = 0;
+#endif
   switch (type_) {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   case arrayValue:
+    value_.array_->clear();
+    break;
   case objectValue:
     value_.map_->clear();
     break;
@@ -859,17 +1090,7 @@ void Value::resize(ArrayIndex newSize) {
   if (type_ == nullValue)
     *this = Value(arrayValue);
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  ArrayIndex oldSize = size();
-  if (newSize == 0)
-    clear();
-  else if (newSize > oldSize)
-    (*this)[newSize - 1];
-  else {
-    for (ArrayIndex index = newSize; index < oldSize; ++index) {
-      value_.map_->erase(index);
-    }
-    assert(size() == newSize);
-  }
+  resizeArray(*value_.array_, newSize);
 #else
   value_.array_->resize(newSize);
 #endif
@@ -882,14 +1103,9 @@ Value& Value::operator[](ArrayIndex index) {
   if (type_ == nullValue)
     *this = Value(arrayValue);
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  CZString key(index);
-  ObjectValues::iterator it = value_.map_->lower_bound(key);
-  if (it != value_.map_->end() && (*it).first == key)
-    return (*it).second;
-
-  ObjectValues::value_type defaultValue(key, null);
-  it = value_.map_->insert(it, defaultValue);
-  return (*it).second;
+  if (index >= value_.array_->size())
+    resizeArray(*value_.array_, index + 1);
+  return (*value_.array_)[index];
 #else
   return value_.array_->resolveReference(index);
 #endif
@@ -909,11 +1125,9 @@ const Value& Value::operator[](ArrayIndex index) const {
   if (type_ == nullValue)
     return null;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  CZString key(index);
-  ObjectValues::const_iterator it = value_.map_->find(key);
-  if (it == value_.map_->end())
+  if (index >= value_.array_->size())
     return null;
-  return (*it).second;
+  return (*value_.array_)[index];
 #else
   Value* value = value_.array_->find(index);
   return value ? *value : null;
@@ -928,29 +1142,54 @@ const Value& Value::operator[](int index) const {
 }
 
 Value& Value::operator[](const char* key) {
-  return resolveReference(key, false);
+  return resolveReference(key, strlen(key), false);
 }
 
 void Value::initBasic(ValueType type, bool allocated) {
   type_ = type;
   allocated_ = allocated;
+  inlined_ = false;
+  length_ = 0;
 #ifdef JSON_VALUE_USE_INTERNAL_MAP
   itemIsUsed_ = 0;
 #endif
   comments_ = 0;
+#ifndef JSON_VALUE_NO_OFFSETS
   start_ = 0;
   limit_ = 0;
+#endif
+}
+
+// Stores a copy of the string in the Value itself if it fits, which spares
+// the allocation of the many short strings of most documents.
+void Value::initString(const char* value, size_t length) {
+  length_ = unsigned(length);
+  if (length < sizeof(value_.chars_)) {
+    memcpy(value_.chars_, value, length);
+    value_.chars_[length] = 0;
+    inlined_ = true;
+  } else {
+    value_.string_ = duplicateStringValue(value, (unsigned int)length);
+    allocated_ = true;
+  }
 }
 
-Value& Value::resolveReference(const char* key, bool isStatic) {
+const char* Value::storedString() const {
+  return inlined_ ? value_.chars_ : value_.string_;
+}
+
+Value&
+Value::resolveReference(const char* key, size_t length, bool isStatic) {
   JSON_ASSERT_MESSAGE(
       type_ == nullValue || type_ == objectValue,
       "in Json::Value::resolveReference(): requires objectValue");
   if (type_ == nullValue)
     *this = Value(objectValue);
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  CZString actualKey(
-      key, isStatic ? CZString::noDuplication : CZString::duplicateOnCopy);
+  CZString actualKey(key,
+                     unsigned(length),
+                     isStatic ? CZString::noDuplication
+                              : CZString::duplicateOnCopy);
   ObjectValues::iterator it = value_.map_->lower_bound(actualKey);
   if (it != value_.map_->end() && (*it).first == actualKey)
     return (*it).second;
@@ -964,6 +1203,124 @@ Value& Value::resolveReference(const char* key, bool isStatic) {
 #endif
 }
 
+void Value::adoptString(char* value, size_t length) {
+  referString(value, length);
+  allocated_ = true;
+}
+
+void Value::referString(const char* value, size_t length) {
+  Value(stringValue).swapPayload(*this);
+  value_.string_ = const_cast<char*>(value);
+  length_ = unsigned(length);
+}
+
+Value& Value::adoptMember(char* key, size_t length) {
+#ifndef JSON_VALUE_USE_INTERNAL_MAP
+  JSON_ASSERT_MESSAGE(type_ == nullValue || type_ == objectValue,
+                      "in Json::Value::adoptMember(): requires objectValue");
+  if (type_ == nullValue)
+    *this = Value(objectValue);
+  CZString actualKey(key, unsigned(length), CZString::noDuplication);
+  ObjectValues::iterator it = value_.map_->lower_bound(actualKey);
+  if (it != value_.map_->end() && (*it).first == actualKey) {
+    releaseStringValue(key);
+    return (*it).second;
+  }
+  // Copying a key stored without duplication does not copy the string, which
+  // the key in the map then takes over.
+  it = value_.map_->insert(it, ObjectValues::value_type(actualKey, null));
+  const_cast<CZString&>((*it).first).adopt();
+  return (*it).second;
+#else
+  Value& value = resolveReference(key, length, false);
+  releaseStringValue(key);
+  return value;
+#endif
+}
+
+char* Value::reusableString(size_t length) {
+  if (type_ == stringValue && inlined_)
+    return length < sizeof(value_.chars_) ? value_.chars_ : 0;
+  if (type_ != stringValue || !allocated_ || value_.string_ == 0 ||
+      length_ < length)
+    return 0;
+  return value_.string_;
+}
+
+char* Value::inlineString(size_t length) {
+  if (length >= sizeof(value_.chars_))
+    return 0;
+  Value(stringValue).swapPayload(*this);
+  inlined_ = true;
+  value_.chars_[0] = 0;
+  return value_.chars_;
+}
+
+void Value::setStringLength(size_t length) {
+  char* string = inlined_ ? value_.chars_ : value_.string_;
+  string[length] = 0;
+  length_ = unsigned(length);
+}
+
+void Value::dropComments() {
+  delete[] comments_;
+  comments_ = 0;
+}
+
+// The id of a member is the string of its key, which moves with the key, or
+// the member itself with the internal map, which never moves it.
+Value& Value::resolveMember(const char* key,
+                            size_t length,
+                            bool isStatic,
+                            const void*& id) {
+#ifndef JSON_VALUE_USE_INTERNAL_MAP
+  JSON_ASSERT_MESSAGE(type_ == nullValue || type_ == objectValue,
+                      "in Json::Value::resolveMember(): requires objectValue");
+  if (type_ == nullValue)
+    *this = Value(objectValue);
+  CZString actualKey(key,
+                     unsigned(length),
+                     isStatic ? CZString::noDuplication
+                              : CZString::duplicateOnCopy);
+  ObjectValues::iterator it = value_.map_->lower_bound(actualKey);
+  if (it == value_.map_->end() || !((*it).first == actualKey))
+    it = value_.map_->insert(it, ObjectValues::value_type(actualKey, null));
+  id = (*it).first.c_str();
+  return (*it).second;
+#else
+  Value& value = resolveReference(key, length, isStatic);
+  id = &value;
+  return value;
+#endif
+}
+
+void Value::retainMembers(const void* const* begin, const void* const* end) {
+  JSON_ASSERT_MESSAGE(type_ == objectValue,
+                      "in Json::Value::retainMembers(): requires objectValue");
+#ifndef JSON_VALUE_USE_INTERNAL_MAP
+  ObjectValues::iterator it = value_.map_->begin();
+  while (it != value_.map_->end()) {
+    const void* id = (*it).first.c_str();
+    if (std::binary_search(begin, end, id))
+      ++it;
+    else
+#ifdef JSON_VALUE_USE_FLAT_MAP
+      it = value_.map_->erase(it);
+#else
+      value_.map_->erase(it++);
+#endif
+  }
+#else
+  const Members names = getMemberNames();
+  Value removed;
+  for (Members::const_iterator it = names.begin(); it != names.end(); ++it) {
+    const void* id = value_.map_->find(it->c_str());
+    if (!std::binary_search(begin, end, id))
+      removeMember(it->c_str(), &removed);
+  }
+#endif
+}
+
 Value Value::get(ArrayIndex index, const Value& defaultValue) const {
   const Value* value = &((*this)[index]);
   return value == &null ? defaultValue : *value;
@@ -975,30 +1332,39 @@ const Value& Value::operator[](const char* key) const {
   JSON_ASSERT_MESSAGE(
       type_ == nullValue || type_ == objectValue,
       "in Json::Value::operator[](char const*)const: requires objectValue");
-  if (type_ == nullValue)
-    return null;
+  const Value* value = find(key, key + strlen(key));
+  return value ? *value : null;
+}
+
+const Value* Value::find(const char* begin, const char* end) const {
+  if (type_ != objectValue)
+    return 0;
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  CZString actualKey(key, CZString::noDuplication);
+  CZString actualKey(begin, unsigned(end - begin), CZString::noDuplication);
   ObjectValues::const_iterator it = value_.map_->find(actualKey);
   if (it == value_.map_->end())
-    return null;
-  return (*it).second;
+    return 0;
+  return &(*it).second;
 #else
-  const Value* value = value_.map_->find(key);
-  return value ? *value : null;
+  return value_.map_->find(begin);
 #endif
 }
 
 Value& Value::operator[](const std::string& key) {
-  return (*this)[key.c_str()];
+  return resolveReference(key.data(), key.length(), false);
 }
 
 const Value& Value::operator[](const std::string& key) const {
-  return (*this)[key.c_str()];
+  JSON_ASSERT_MESSAGE(
+      type_ == nullValue || type_ == objectValue,
+      "in Json::Value::operator[](std::string const&)const: requires "
+      "objectValue");
+  const Value* value = find(key.data(), key.data() + key.length());
+  return value ? *value : null;
 }
 
 Value& Value::operator[](const StaticString& key) {
-  return resolveReference(key, true);
+  return resolveReference(key, strlen(key), true);
 }
 
 #ifdef JSON_USE_CPPTL
@@ -1019,16 +1385,21 @@ Value Value::get(const char* key, const Value& defaultValue) const {
 }
 
 Value Value::get(const std::string& key, const Value& defaultValue) const {
-  return get(key.c_str(), defaultValue);
+  const Value* value = &((*this)[key]);
+  return value == &null ? defaultValue : *value;
 }
 
 
 bool Value::removeMember(const char* key, Value* removed) {
+  return removeMember(key, key + strlen(key), removed);
+}
+
+bool Value::removeMember(const char* begin, const char* end, Value* removed) {
   if (type_ != objectValue) {
     return false;
   }
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  CZString actualKey(key, CZString::noDuplication);
+  CZString actualKey(begin, unsigned(end - begin), CZString::noDuplication);
   ObjectValues::iterator it = value_.map_->find(actualKey);
   if (it == value_.map_->end())
     return false;
@@ -1036,10 +1407,10 @@ bool Value::removeMember(const char* key, Value* removed) {
   value_.map_->erase(it);
   return true;
 #else
-  Value* value = value_.map_->find(key);
+  Value* value = value_.map_->find(begin);
   if (value) {
     *removed = *value;
-    value_.map_.remove(key);
+    value_.map_.remove(begin);
     return true;
   } else {
     return false;
@@ -1059,7 +1430,11 @@ Value Value::removeMember(const char* key) {
 }
 
 Value Value::removeMember(const std::string& key) {
-  return removeMember(key.c_str());
+  JSON_ASSERT_MESSAGE(type_ == nullValue || type_ == objectValue,
+                      "in Json::Value::removeMember(): requires objectValue");
+  Value removed;  // null
+  removeMember(key.data(), key.data() + key.length(), &removed);
+  return removed;
 }
 
 bool Value::removeIndex(ArrayIndex index, Value* removed) {
@@ -1070,22 +1445,15 @@ bool Value::removeIndex(ArrayIndex index, Value* removed) {
   JSON_FAIL_MESSAGE("removeIndex is not implemented for ValueInternalArray.");
   return false;
 #else
-  CZString key(index);
-  ObjectValues::iterator it = value_.map_->find(key);
-  if (it == value_.map_->end()) {
+  ArrayValues& array = *value_.array_;
+  if (index >= array.size()) {
     return false;
   }
-  *removed = it->second;
-  ArrayIndex oldSize = size();
+  removed->swap(array[index]);
   // shift left all items left, into the place of the "removed"
-  for (ArrayIndex i = index; i < (oldSize - 1); ++i){
-    CZString key(i);
-    (*value_.map_)[key] = (*this)[i + 1];
-  }
-  // erase the last one ("leftover")
-  CZString keyLast(oldSize - 1);
-  ObjectValues::iterator itLast = value_.map_->find(keyLast);
-  value_.map_->erase(itLast);
+  for (ArrayIndex i = index; i + 1 < array.size(); ++i)
+    array[i].swap(array[i + 1]);
+  array.pop_back();
   return true;
 #endif
 }
@@ -1103,7 +1471,8 @@ bool Value::isMember(const char* key) const {
 }
 
 bool Value::isMember(const std::string& key) const {
-  return isMember(key.c_str());
+  const Value* value = &((*this)[key]);
+  return value != &null;
 }
 
 #ifdef JSON_USE_CPPTL
@@ -1124,7 +1493,8 @@ Value::Members Value::getMemberNames() const {
   ObjectValues::const_iterator it = value_.map_->begin();
   ObjectValues::const_iterator itEnd = value_.map_->end();
   for (; it != itEnd; ++it)
-    members.push_back(std::string((*it).first.c_str()));
+    members.push_back(
+        std::string((*it).first.c_str(), (*it).first.length()));
 #else
   ValueInternalMap::IteratorState it;
   ValueInternalMap::IteratorState itEnd;
@@ -1278,6 +1648,7 @@ std::string Value::getComment(CommentPlacement placement) const {
   return "";
 }
 
+#ifndef JSON_VALUE_NO_OFFSETS
 void Value::setOffsetStart(size_t start) { start_ = start; }
 
 void Value::setOffsetLimit(size_t limit) { limit_ = limit; }
@@ -1285,6 +1656,15 @@ void Value::setOffsetLimit(size_t limit) { limit_ = limit; }
 size_t Value::getOffsetStart() const { return start_; }
 
 size_t Value::getOffsetLimit() const { return limit_; }
+#else
+void Value::setOffsetStart(size_t) {}
+
+void Value::setOffsetLimit(size_t) {}
+
+size_t Value::getOffsetStart() const { return 0; }
+
+size_t Value::getOffsetLimit() const { return 0; }
+#endif
 
 std::string Value::toStyledString() const {
   StyledWriter writer;
@@ -1310,6 +1690,9 @@ Value::const_iterator Value::begin() const {
     break;
 #else
   case arrayValue:
+    if (value_.array_)
+      return const_iterator(value_.array_->begin(), 0);
+    break;
   case objectValue:
     if (value_.map_)
       return const_iterator(value_.map_->begin());
@@ -1340,6 +1723,9 @@ Value::const_iterator Value::end() const {
     break;
 #else
   case arrayValue:
+    if (value_.array_)
+      return const_iterator(value_.array_->end(), size());
+    break;
   case objectValue:
     if (value_.map_)
       return const_iterator(value_.map_->end());
@@ -1370,6 +1756,9 @@ Value::iterator Value::begin() {
     break;
 #else
   case arrayValue:
+    if (value_.array_)
+      return iterator(value_.array_->begin(), 0);
+    break;
   case objectValue:
     if (value_.map_)
       return iterator(value_.map_->begin());
@@ -1400,6 +1789,9 @@ Value::iterator Value::end() {
     break;
 #else
   case arrayValue:
+    if (value_.array_)
+      return iterator(value_.array_->end(), size());
+    break;
   case objectValue:
     if (value_.map_)
       return iterator(value_.map_->end());
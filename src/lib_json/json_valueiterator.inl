@@ -17,7 +17,7 @@ namespace Json {
 
 ValueIteratorBase::ValueIteratorBase()
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-    : current_(), isNull_(true) {
+    : current_(), element_(), index_(0), isNull_(true), isArray_(false) {
 }
 #else
     : isArray_(true), isNull_(true) {
@@ -28,7 +28,13 @@ ValueIteratorBase::ValueIteratorBase()
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
 ValueIteratorBase::ValueIteratorBase(
     const Value::ObjectValues::iterator& current)
-    : current_(current), isNull_(false) {}
+    : current_(current), element_(), index_(0), isNull_(false),
+      isArray_(false) {}
+
+ValueIteratorBase::ValueIteratorBase(
+    const Value::ArrayValues::iterator& current, ArrayIndex index)
+    : current_(), element_(current), index_(index), isNull_(false),
+      isArray_(true) {}
 #else
 ValueIteratorBase::ValueIteratorBase(
     const ValueInternalArray::IteratorState& state)
@@ -45,6 +51,8 @@ ValueIteratorBase::ValueIteratorBase(
 
 Value& ValueIteratorBase::deref() const {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
+  if (isArray_)
+    return *element_;
   return current_->second;
 #else
   if (isArray_)
@@ -55,7 +63,12 @@ Value& ValueIteratorBase::deref() const {
 
 void ValueIteratorBase::increment() {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  ++current_;
+  if (isArray_) {
+    ++element_;
+    ++index_;
+  } else {
+    ++current_;
+  }
 #else
   if (isArray_)
     ValueInternalArray::increment(iterator_.array_);
@@ -65,7 +78,12 @@ void ValueIteratorBase::increment() {
 
 void ValueIteratorBase::decrement() {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  --current_;
+  if (isArray_) {
+    --element_;
+    --index_;
+  } else {
+    --current_;
+  }
 #else
   if (isArray_)
     ValueInternalArray::decrement(iterator_.array_);
@@ -77,7 +95,9 @@ ValueIteratorBase::difference_type
 ValueIteratorBase::computeDistance(const SelfType& other) const {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
 #ifdef JSON_USE_CPPTL_SMALLMAP
-  return current_ - other.current_;
+  if (isArray_)
+    return difference_type(other.element_ - element_);
+  return other.current_ - current_;
 #else
   // Iterator for null value are initialized using the default
   // constructor, which initialize current_ to the default
@@ -87,7 +107,11 @@ ValueIteratorBase::computeDistance(const SelfType& other) const {
   if (isNull_ && other.isNull_) {
     return 0;
   }
-
+  if (isArray_)
+    return difference_type(other.element_ - element_);
+#ifdef JSON_VALUE_USE_FLAT_MAP
+  return difference_type(other.current_ - current_);
+#else
   // Usage of std::distance is not portable (does not compile with Sun Studio 12
   // RogueWave STL,
   // which is the one used by default).
@@ -99,6 +123,7 @@ ValueIteratorBase::computeDistance(const SelfType& other) const {
     ++myDistance;
   }
   return myDistance;
+#endif // ifdef JSON_VALUE_USE_FLAT_MAP
 #endif
 #else
   if (isArray_)
@@ -113,6 +138,8 @@ bool ValueIteratorBase::isEqual(const SelfType& other) const {
   if (isNull_) {
     return other.isNull_;
   }
+  if (isArray_)
+    return element_ == other.element_;
   return current_ == other.current_;
 #else
   if (isArray_)
@@ -124,7 +151,10 @@ bool ValueIteratorBase::isEqual(const SelfType& other) const {
 void ValueIteratorBase::copy(const SelfType& other) {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
   current_ = other.current_;
+  element_ = other.element_;
+  index_ = other.index_;
   isNull_ = other.isNull_;
+  isArray_ = other.isArray_;
 #else
   if (isArray_)
     iterator_.array_ = other.iterator_.array_;
@@ -134,11 +164,16 @@ void ValueIteratorBase::copy(const SelfType& other) {
 
 Value ValueIteratorBase::key() const {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  const Value::CZString czstring = (*current_).first;
+  if (isArray_)
+    return Value(index_);
+  const Value::CZString& czstring = (*current_).first;
   if (czstring.c_str()) {
-    if (czstring.isStaticString())
-      return Value(StaticString(czstring.c_str()));
-    return Value(czstring.c_str());
+    if (czstring.isStaticString()) {
+      Value name(stringValue);
+      name.referString(czstring.c_str(), czstring.length());
+      return name;
+    }
+    return Value(czstring.c_str(), czstring.c_str() + czstring.length());
   }
   return Value(czstring.index());
 #else
@@ -154,7 +189,9 @@ Value ValueIteratorBase::key() const {
 
 UInt ValueIteratorBase::index() const {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
-  const Value::CZString czstring = (*current_).first;
+  if (isArray_)
+    return index_;
+  const Value::CZString& czstring = (*current_).first;
   if (!czstring.c_str())
     return czstring.index();
   return Value::UInt(-1);
@@ -167,6 +204,8 @@ UInt ValueIteratorBase::index() const {
 
 const char* ValueIteratorBase::memberName() const {
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
+  if (isArray_)
+    return "";
   const char* name = (*current_).first.c_str();
   return name ? name : "";
 #else
@@ -176,6 +215,26 @@ const char* ValueIteratorBase::memberName() const {
 #endif
 }
 
+const char* ValueIteratorBase::memberName(const char** end) const {
+#ifndef JSON_VALUE_USE_INTERNAL_MAP
+  if (!isArray_) {
+    const Value::CZString& czstring = (*current_).first;
+    if (czstring.c_str()) {
+      *end = czstring.c_str() + czstring.length();
+      return czstring.c_str();
+    }
+  }
+#else
+  if (!isArray_) {
+    const char* name = ValueInternalMap::key(iterator_.map_);
+    *end = name + strlen(name);
+    return name;
+  }
+#endif
+  *end = "";
+  return *end;
+}
+
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
@@ -190,6 +249,10 @@ ValueConstIterator::ValueConstIterator() {}
 ValueConstIterator::ValueConstIterator(
     const Value::ObjectValues::iterator& current)
     : ValueIteratorBase(current) {}
+
+ValueConstIterator::ValueConstIterator(
+    const Value::ArrayValues::iterator& current, ArrayIndex index)
+    : ValueIteratorBase(current, index) {}
 #else
 ValueConstIterator::ValueConstIterator(
     const ValueInternalArray::IteratorState& state)
@@ -219,6 +282,10 @@ ValueIterator::ValueIterator() {}
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
 ValueIterator::ValueIterator(const Value::ObjectValues::iterator& current)
     : ValueIteratorBase(current) {}
+
+ValueIterator::ValueIterator(const Value::ArrayValues::iterator& current,
+                             ArrayIndex index)
+    : ValueIteratorBase(current, index) {}
 #else
 ValueIterator::ValueIterator(const ValueInternalArray::IteratorState& state)
     : ValueIteratorBase(state) {}
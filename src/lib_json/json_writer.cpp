@@ -7,6 +7,7 @@
 #include <json/writer.h>
 #include "json_tool.h"
 #endif // if !defined(JSON_IS_AMALGAMATION)
+#include <algorithm>
 #include <utility>
 #include <assert.h>
 #include <stdio.h>
@@ -33,9 +34,10 @@
 
 namespace Json {
 
-static bool containsControlCharacter(const char* str) {
-  while (*str) {
-    if (isControlCharacter(*(str++)))
+// Also true of the '\0' characters a string of known length may contain.
+static bool containsControlCharacter(const char* str, const char* end) {
+  for (; str != end; ++str) {
+    if (isControlCharacter(*str) || *str == 0)
       return true;
   }
   return false;
@@ -104,22 +106,27 @@ std::string valueToString(double value) {
 
 std::string valueToString(bool value) { return value ? "true" : "false"; }
 
-std::string valueToQuotedString(const char* value) {
-  if (value == NULL)
-    return "";
+static std::string valueToQuotedStringN(const char* value, const char* end) {
   // Not sure how to handle unicode...
-  if (strpbrk(value, "\"\\\b\f\n\r\t") == NULL &&
-      !containsControlCharacter(value))
-    return std::string("\"") + value + "\"";
+  if (std::find(value, end, '"') == end &&
+      std::find(value, end, '\\') == end &&
+      !containsControlCharacter(value, end)) {
+    std::string result;
+    result.reserve(end - value + 2);
+    result += '"';
+    result.append(value, end);
+    result += '"';
+    return result;
+  }
   // We have to walk value and escape any special characters.
   // Appending to std::string is not efficient, but this should be rare.
   // (Note: forward slashes are *not* rare, but I am not escaping them.)
   std::string::size_type maxsize =
-      strlen(value) * 2 + 3; // allescaped+quotes+NULL
+      (end - value) * 2 + 3; // allescaped+quotes+NULL
   std::string result;
   result.reserve(maxsize); // to avoid lots of mallocs
   result += "\"";
-  for (const char* c = value; *c != 0; ++c) {
+  for (const char* c = value; c != end; ++c) {
     switch (*c) {
     case '\"':
       result += "\\\"";
@@ -151,7 +158,7 @@ std::string valueToQuotedString(const char* value) {
     // Should add a flag to allow this compatibility mode and prevent this
     // sequence from occurring.
     default:
-      if (isControlCharacter(*c)) {
+      if (isControlCharacter(*c) || *c == 0) {
         std::ostringstream oss;
         oss << "\\u" << std::hex << std::uppercase << std::setfill('0')
             << std::setw(4) << static_cast<int>(*c);
@@ -166,6 +173,25 @@ std::string valueToQuotedString(const char* value) {
   return result;
 }
 
+std::string valueToQuotedString(const char* value) {
+  if (value == NULL)
+    return "";
+  return valueToQuotedStringN(value, value + strlen(value));
+}
+
+// Quotes the whole range of a string that may contain '\0' characters.
+static std::string valueToQuotedString(const Value& value) {
+  const char* begin;
+  const char* end;
+  if (!value.getString(&begin, &end))
+    return valueToQuotedString(value.asCString());
+  return valueToQuotedStringN(begin, end);
+}
+
+static std::string valueToQuotedString(const std::string& value) {
+  return valueToQuotedStringN(value.data(), value.data() + value.length());
+}
+
 // Class Writer
 // //////////////////////////////////////////////////////////////////
 Writer::~Writer() {}
@@ -207,7 +233,7 @@ void FastWriter::writeValue(const Value& value) {
     document_ += valueToString(value.asDouble());
     break;
   case stringValue:
-    document_ += valueToQuotedString(value.asCString());
+    document_ += valueToQuotedString(value);
     break;
   case booleanValue:
     document_ += valueToString(value.asBool());
@@ -230,7 +256,7 @@ void FastWriter::writeValue(const Value& value) {
       const std::string& name = *it;
       if (it != members.begin())
         document_ += ',';
-      document_ += valueToQuotedString(name.c_str());
+      document_ += valueToQuotedString(name);
       document_ += yamlCompatiblityEnabled_ ? ": " : ":";
       writeValue(value[name]);
     }
@@ -290,7 +316,7 @@ void StyledWriterMethods::writeValue(const Value& value) {
     pushValue(valueToString(value.asDouble()));
     break;
   case stringValue:
-    pushValue(valueToQuotedString(value.asCString()));
+    pushValue(valueToQuotedString(value));
     break;
   case booleanValue:
     pushValue(valueToString(value.asBool()));
@@ -311,7 +337,7 @@ void StyledWriterMethods::writeValue(const Value& value) {
         const Value& childValue = value[name];
         writeCommentBeforeValue(childValue);
         writeIndent();
-        write(valueToQuotedString(name.c_str()).c_str());
+        write(valueToQuotedString(name).c_str());
         write(" : ");
         // TODO: writeIndent() here for multiline arrays & objects?
         writeValue(childValue);
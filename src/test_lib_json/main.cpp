@@ -6,6 +6,7 @@
 #include "jsontest.h"
 #include <json/config.h>
 #include <json/json.h>
+#include <algorithm>
 #include <stdexcept>
 
 // Make numeric limits more convenient to talk about.
@@ -1500,6 +1501,7 @@ JSONTEST_FIXTURE(ValueTest, offsetAccessors) {
   Json::Value x;
   JSONTEST_ASSERT(x.getOffsetStart() == 0);
   JSONTEST_ASSERT(x.getOffsetLimit() == 0);
+#ifndef JSON_VALUE_NO_OFFSETS
   x.setOffsetStart(10);
   x.setOffsetLimit(20);
   JSONTEST_ASSERT(x.getOffsetStart() == 10);
@@ -1513,6 +1515,277 @@ JSONTEST_FIXTURE(ValueTest, offsetAccessors) {
   JSONTEST_ASSERT(z.getOffsetLimit() == 20);
   JSONTEST_ASSERT(y.getOffsetStart() == 0);
   JSONTEST_ASSERT(y.getOffsetLimit() == 0);
+#endif
+}
+
+JSONTEST_FIXTURE(ValueTest, arrayStorage) {
+  // Growing an array keeps its elements, with their comments and subtrees.
+  Json::Value array;
+  for (int index = 0; index < 1000; ++index) {
+    Json::Value& element = array.append(Json::Value(Json::objectValue));
+    element["index"] = index;
+    if (index % 100 == 0)
+      element.setComment("// hundred", Json::commentBefore);
+  }
+  JSONTEST_ASSERT_EQUAL(1000u, array.size());
+  JSONTEST_ASSERT_EQUAL(999, array[999]["index"].asInt());
+  JSONTEST_ASSERT_STRING_EQUAL("// hundred",
+                               array[300].getComment(Json::commentBefore));
+
+  // Iterators walk the elements in order and know their index.
+  const Json::Value& constArray = array;
+  int expected = 0;
+  for (Json::Value::const_iterator it = constArray.begin();
+       it != constArray.end();
+       ++it, ++expected) {
+    JSONTEST_ASSERT_EQUAL(expected, (*it)["index"].asInt());
+    JSONTEST_ASSERT_EQUAL(Json::UInt(expected), it.index());
+    JSONTEST_ASSERT_EQUAL(Json::Value(Json::UInt(expected)), it.key());
+    JSONTEST_ASSERT_STRING_EQUAL("", it.memberName());
+  }
+  JSONTEST_ASSERT_EQUAL(1000, array.end() - array.begin());
+  Json::Value::iterator last = array.end();
+  --last;
+  JSONTEST_ASSERT_EQUAL(999u, last.index());
+  (*last)["index"] = -1;
+  JSONTEST_ASSERT_EQUAL(-1, array[999]["index"].asInt());
+
+  // Elements are removed and the array truncated in place.
+  Json::Value removed;
+  JSONTEST_ASSERT(array.removeIndex(0, &removed));
+  JSONTEST_ASSERT_EQUAL(0, removed["index"].asInt());
+  JSONTEST_ASSERT(removed.hasComment(Json::commentBefore));
+  JSONTEST_ASSERT_EQUAL(999u, array.size());
+  JSONTEST_ASSERT_EQUAL(1, array[0u]["index"].asInt());
+  JSONTEST_ASSERT(!array.removeIndex(999, &removed));
+  array.resize(2);
+  JSONTEST_ASSERT_EQUAL(2, array[1]["index"].asInt());
+
+  // Copies and comparisons work element by element.
+  Json::Value copy(array);
+  JSONTEST_ASSERT(copy == array);
+  copy[1]["index"] = 3;
+  JSONTEST_ASSERT(array < copy);
+  copy.resize(5);
+  JSONTEST_ASSERT(copy[4].isNull());
+  JSONTEST_ASSERT(array < copy);
+  const Json::Value& constCopy = copy;
+  JSONTEST_ASSERT(constCopy[7].isNull());
+  JSONTEST_ASSERT_EQUAL(5u, copy.size());
+}
+
+JSONTEST_FIXTURE(ValueTest, objectStorage) {
+  // Members added in any order are kept, and iterated, by name.
+  Json::Value object;
+  for (int index = 0; index < 200; ++index) {
+    const int number = (index * 37) % 200;
+    std::ostringstream name;
+    name << "key" << number;
+    Json::Value& member = object[name.str()];
+    member["number"] = number;
+    if (number % 50 == 0)
+      member.setComment("// fifty", Json::commentBefore);
+  }
+  JSONTEST_ASSERT_EQUAL(200u, object.size());
+  JSONTEST_ASSERT_EQUAL(123, object["key123"]["number"].asInt());
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "// fifty", object["key150"].getComment(Json::commentBefore));
+
+  const Json::Value& constObject = object;
+  Json::Value::Members names = object.getMemberNames();
+  JSONTEST_ASSERT_EQUAL(200u, names.size());
+  Json::Value::Members::const_iterator name = names.begin();
+  for (Json::Value::const_iterator it = constObject.begin();
+       it != constObject.end();
+       ++it, ++name) {
+    JSONTEST_ASSERT_STRING_EQUAL(*name, it.memberName());
+    JSONTEST_ASSERT(!(*it)["number"].isNull());
+  }
+  // Names holding numbers are ordered by value.
+  JSONTEST_ASSERT_STRING_EQUAL("key0", names[0]);
+  JSONTEST_ASSERT_STRING_EQUAL("key1", names[1]);
+  JSONTEST_ASSERT_STRING_EQUAL("key2", names[2]);
+  JSONTEST_ASSERT_STRING_EQUAL("key199", names[199]);
+  JSONTEST_ASSERT_EQUAL(200, constObject.end() - constObject.begin());
+  JSONTEST_ASSERT(constObject.isMember("key42"));
+  JSONTEST_ASSERT(!constObject.isMember("key200"));
+  JSONTEST_ASSERT(constObject["key200"].isNull());
+  JSONTEST_ASSERT_EQUAL(200u, object.size());
+
+  // Members are removed without disturbing the others.
+  Json::Value removed = object.removeMember("key0");
+  JSONTEST_ASSERT_EQUAL(0, removed["number"].asInt());
+  JSONTEST_ASSERT(removed.hasComment(Json::commentBefore));
+  object.removeMember("key100");
+  object.removeMember("key199");
+  JSONTEST_ASSERT_EQUAL(197u, object.size());
+  JSONTEST_ASSERT_STRING_EQUAL("key1", object.getMemberNames()[0]);
+  JSONTEST_ASSERT_EQUAL(99, object["key99"]["number"].asInt());
+  JSONTEST_ASSERT_EQUAL(101, object["key101"]["number"].asInt());
+
+  // Copies compare equal, and the writers output the members by name.
+  Json::Value copy(object);
+  JSONTEST_ASSERT(copy == object);
+  copy["key1"]["number"] = 2;
+  JSONTEST_ASSERT(object < copy);
+  Json::Value small;
+  small["b"] = 2;
+  small["a10"] = 3;
+  small["a9"] = 1;
+  Json::FastWriter writer;
+  JSONTEST_ASSERT_STRING_EQUAL("{\"a9\":1,\"a10\":3,\"b\":2}\n",
+                               writer.write(small));
+  small.clear();
+  JSONTEST_ASSERT_EQUAL(0u, small.size());
+  JSONTEST_ASSERT(small.isObject());
+}
+
+static bool isStoredIn(const Json::Value& value, const char* string) {
+  const char* storage = reinterpret_cast<const char*>(&value);
+  return string >= storage && string < storage + sizeof(value);
+}
+
+JSONTEST_FIXTURE(ValueTest, shortStrings) {
+  // Strings shorter than 8 bytes are stored in the Value itself.
+  Json::Value empty("");
+  Json::Value ok("ok");
+  Json::Value seven(std::string("1234567"));
+  Json::Value eight("12345678");
+  const char* range = "GET /";
+  Json::Value get(range, range + 3);
+  JSONTEST_ASSERT(isStoredIn(empty, empty.asCString()));
+  JSONTEST_ASSERT(isStoredIn(ok, ok.asCString()));
+  JSONTEST_ASSERT(isStoredIn(seven, seven.asCString()));
+  JSONTEST_ASSERT(isStoredIn(get, get.asCString()));
+  JSONTEST_ASSERT(!isStoredIn(eight, eight.asCString()));
+  JSONTEST_ASSERT_STRING_EQUAL("", empty.asString());
+  JSONTEST_ASSERT_STRING_EQUAL("ok", ok.asCString());
+  JSONTEST_ASSERT_STRING_EQUAL("1234567", seven.asString());
+  JSONTEST_ASSERT_STRING_EQUAL("12345678", eight.asString());
+  JSONTEST_ASSERT_STRING_EQUAL("GET", get.asString());
+  // Static strings are still referenced.
+  const char* literal = "ok";
+  JSONTEST_ASSERT(Json::Value(Json::StaticString(literal)).asCString() ==
+                  literal);
+
+  // Short and long strings compare, copy and swap alike.
+  JSONTEST_ASSERT(Json::Value("ok") == ok);
+  JSONTEST_ASSERT(Json::Value(Json::StaticString("ok")) == ok);
+  JSONTEST_ASSERT(seven < eight);
+  JSONTEST_ASSERT(eight < ok);
+  JSONTEST_ASSERT(!(ok < ok));
+  JSONTEST_ASSERT(empty < ok);
+  Json::Value copy(ok);
+  JSONTEST_ASSERT(isStoredIn(copy, copy.asCString()));
+  JSONTEST_ASSERT_STRING_EQUAL("ok", copy.asString());
+  copy.swap(eight);
+  JSONTEST_ASSERT_STRING_EQUAL("12345678", copy.asString());
+  JSONTEST_ASSERT_STRING_EQUAL("ok", eight.asString());
+  JSONTEST_ASSERT(isStoredIn(eight, eight.asCString()));
+  copy = ok;
+  JSONTEST_ASSERT_STRING_EQUAL("ok", copy.asString());
+
+  // Elements keep their strings when the array grows.
+  Json::Value array;
+  for (int index = 0; index < 100; ++index)
+    array.append(index % 2 ? "odd" : "even number");
+  JSONTEST_ASSERT_STRING_EQUAL("odd", array[99].asString());
+  JSONTEST_ASSERT_STRING_EQUAL("even number", array[98].asString());
+  array.resize(2);
+  JSONTEST_ASSERT_STRING_EQUAL("[\"even number\",\"odd\"]\n",
+                               Json::FastWriter().write(array));
+
+  // The reader decodes short strings into the Value.
+  Json::Reader reader;
+  Json::Value root;
+  JSONTEST_ASSERT(reader.parse(
+      "[\"GET\", \"caf\\u00e9\", \"\\n\\t\", \"1234567\", \"12345678\"]",
+      root));
+  JSONTEST_ASSERT_STRING_EQUAL("GET", root[0].asString());
+  JSONTEST_ASSERT_STRING_EQUAL("caf\xc3\xa9", root[1].asString());
+  JSONTEST_ASSERT_STRING_EQUAL("\n\t", root[2].asString());
+  JSONTEST_ASSERT_STRING_EQUAL("1234567", root[3].asString());
+  JSONTEST_ASSERT_STRING_EQUAL("12345678", root[4].asString());
+  // Strings are stored inline when their token, escapes included, is short.
+  JSONTEST_ASSERT(isStoredIn(root[0], root[0].asCString()));
+  JSONTEST_ASSERT(!isStoredIn(root[1], root[1].asCString()));
+  JSONTEST_ASSERT(isStoredIn(root[2], root[2].asCString()));
+  JSONTEST_ASSERT(isStoredIn(root[3], root[3].asCString()));
+  JSONTEST_ASSERT(!isStoredIn(root[4], root[4].asCString()));
+  JSONTEST_ASSERT(reader.parseInto("[\"POST\", \"a\", \"long enough\"]", root));
+  JSONTEST_ASSERT_EQUAL(3u, root.size());
+  JSONTEST_ASSERT_STRING_EQUAL("POST", root[0].asString());
+  JSONTEST_ASSERT_STRING_EQUAL("a", root[1].asString());
+  JSONTEST_ASSERT_STRING_EQUAL("long enough", root[2].asString());
+  JSONTEST_ASSERT(isStoredIn(root[0], root[0].asCString()));
+}
+
+JSONTEST_FIXTURE(ValueTest, embeddedNul) {
+  const std::string binary("a\0b\0long tail", 13);
+  Json::Value value(binary);
+  JSONTEST_ASSERT_EQUAL(13u, value.asString().length());
+  JSONTEST_ASSERT(binary == value.asString());
+  const char* begin;
+  const char* end;
+  JSONTEST_ASSERT(value.getString(&begin, &end));
+  JSONTEST_ASSERT_EQUAL(13, end - begin);
+  JSONTEST_ASSERT(!Json::Value(Json::stringValue).getString(&begin, &end));
+  JSONTEST_ASSERT(!Json::Value(12).getString(&begin, &end));
+
+  // Strings differing after a '\0' are distinct and ordered.
+  const Json::Value shortValue(std::string("x\0a", 3));
+  const Json::Value shortOther(std::string("x\0b", 3));
+  JSONTEST_ASSERT(shortValue != shortOther);
+  JSONTEST_ASSERT(shortValue < shortOther);
+  JSONTEST_ASSERT(Json::Value("x") < shortValue);
+  JSONTEST_ASSERT(Json::Value(shortValue) == shortValue);
+  JSONTEST_ASSERT(Json::Value(value) == value);
+
+  // Keys too.
+  Json::Value object;
+  object[std::string("k\0a", 3)] = 1;
+  object[std::string("k\0b", 3)] = 2;
+  object["k"] = 3;
+  JSONTEST_ASSERT_EQUAL(3u, object.size());
+  JSONTEST_ASSERT_EQUAL(2, object[std::string("k\0b", 3)].asInt());
+  const char* key = "k\0a";
+  const Json::Value* member = object.find(key, key + 3);
+  JSONTEST_ASSERT(member != 0 && member->asInt() == 1);
+  JSONTEST_ASSERT(object.find(key, key + 2) == 0);
+  Json::Value::Members names = object.getMemberNames();
+  JSONTEST_ASSERT_EQUAL(1u, names[0].length());
+  JSONTEST_ASSERT(names[1] == std::string("k\0a", 3));
+  Json::Value::iterator it = object.begin();
+  JSONTEST_ASSERT_STRING_EQUAL("k", it.key().asString());
+  ++it;
+  const char* name = it.memberName(&end);
+  JSONTEST_ASSERT_EQUAL(3, end - name);
+  JSONTEST_ASSERT(it.key() == Json::Value(name, end));
+  Json::Value removed;
+  JSONTEST_ASSERT(object.removeMember(key, key + 3, &removed));
+  JSONTEST_ASSERT_EQUAL(1, removed.asInt());
+  JSONTEST_ASSERT(!object.isMember(std::string("k\0a", 3)));
+  JSONTEST_ASSERT(object.isMember("k"));
+
+  // The reader decodes "\u0000", and the writers escape it back.
+  const std::string document =
+      "{\"k\\u0000\":[\"\\u0000\",\"a\\u0000b c d e\"]}";
+  Json::Reader reader;
+  Json::Value root;
+  JSONTEST_ASSERT(reader.parse(document, root));
+  const Json::Value array = root[std::string("k\0", 2)];
+  JSONTEST_ASSERT_EQUAL(2u, array.size());
+  JSONTEST_ASSERT(array[0].asString() == std::string(1, '\0'));
+  JSONTEST_ASSERT(array[1].asString() == std::string("a\0b c d e", 9));
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "{\"k\\u0000\":[\"\\u0000\",\"a\\u0000b c d e\"]}\n",
+      Json::FastWriter().write(root));
+  std::vector<char> buffer(document.begin(), document.end());
+  JSONTEST_ASSERT(reader.parseInSitu(
+      &buffer[0], &buffer[0] + buffer.size(), root));
+  JSONTEST_ASSERT(root[std::string("k\0", 2)][1] == array[1]);
+  JSONTEST_ASSERT(reader.parseInto(document, root));
+  JSONTEST_ASSERT(root[std::string("k\0", 2)][1].asString().length() == 9);
 }
 
 struct WriterTest : JsonTest::TestCase {};
@@ -1547,6 +1820,7 @@ JSONTEST_FIXTURE(ReaderTest, parseWithNoErrorsTestingOffsets) {
   JSONTEST_ASSERT(ok);
   JSONTEST_ASSERT(reader.getFormattedErrorMessages().size() == 0);
   JSONTEST_ASSERT(reader.getStructuredErrors().size() == 0);
+#ifndef JSON_VALUE_NO_OFFSETS
   JSONTEST_ASSERT(root["property"].getOffsetStart() == 15);
   JSONTEST_ASSERT(root["property"].getOffsetLimit() == 34);
   JSONTEST_ASSERT(root["property"][0].getOffsetStart() == 16);
@@ -1565,6 +1839,7 @@ JSONTEST_FIXTURE(ReaderTest, parseWithNoErrorsTestingOffsets) {
   JSONTEST_ASSERT(root["false"].getOffsetLimit() == 108);
   JSONTEST_ASSERT(root.getOffsetStart() == 0);
   JSONTEST_ASSERT(root.getOffsetLimit() == 110);
+#endif
 }
 
 JSONTEST_FIXTURE(ReaderTest, parseWithOneError) {
@@ -1617,6 +1892,1126 @@ JSONTEST_FIXTURE(ReaderTest, parseWithDetailError) {
   JSONTEST_ASSERT(errors.at(0).message == "Bad escape sequence in string");
 }
 
+JSONTEST_FIXTURE(ReaderTest, parseLongStringsAndWhitespace) {
+  // Lengths straddle the 16 and 32 byte blocks of the vectorized scanner.
+  for (int length = 0; length < 70; ++length) {
+    std::string body;
+    for (int index = 0; index < length; ++index)
+      body += char('a' + index % 26);
+    std::string document = std::string(length, ' ') + "[\"" + body + "\\\"" +
+                           body + "\"," + std::string(length, '\t') + "1]";
+    Json::Reader reader;
+    Json::Value root;
+    JSONTEST_ASSERT(reader.parse(document, root));
+    JSONTEST_ASSERT_STRING_EQUAL(body + "\"" + body, root[0u].asString());
+    JSONTEST_ASSERT_EQUAL(1, root[1u].asInt());
+
+    std::string padding(length, ' ');
+    JSONTEST_ASSERT(reader.parse("[1" + padding + "// c\n]", root));
+    JSONTEST_ASSERT_STRING_EQUAL(
+        "// c", root[0u].getComment(Json::commentAfterOnSameLine));
+    JSONTEST_ASSERT(
+        reader.parse("[1" + padding + "\n" + padding + "// c\n]", root));
+    JSONTEST_ASSERT(!root[0u].hasComment(Json::commentAfterOnSameLine));
+    JSONTEST_ASSERT_STRING_EQUAL("// c", root[0u].getComment(Json::commentAfter));
+
+    JSONTEST_ASSERT(!reader.parse("[\"" + body + "]", root));
+  }
+}
+
+struct EventRecorder : Json::ReaderHandler {
+  std::string events;
+  int eventLimit;
+
+  EventRecorder() : eventLimit(-1) {}
+
+  bool record(const std::string& event) {
+    if (!events.empty())
+      events += ' ';
+    events += event;
+    return eventLimit < 0 || --eventLimit > 0;
+  }
+
+  virtual bool null() { return record("null"); }
+  virtual bool boolean(bool value) { return record(value ? "true" : "false"); }
+  virtual bool integer(Json::LargestInt value) {
+    return record("i:" + Json::valueToString(value));
+  }
+  virtual bool unsignedInteger(Json::LargestUInt value) {
+    return record("u:" + Json::valueToString(value));
+  }
+  virtual bool real(double value) {
+    return record("d:" + Json::valueToString(value));
+  }
+  virtual bool string(const char* begin, const char* end) {
+    return record("s:" + std::string(begin, end));
+  }
+  virtual bool startObject() { return record("{"); }
+  virtual bool key(const char* begin, const char* end) {
+    return record("k:" + std::string(begin, end));
+  }
+  virtual bool endObject() { return record("}"); }
+  virtual bool startArray() { return record("["); }
+  virtual bool endArray() { return record("]"); }
+};
+
+JSONTEST_FIXTURE(ReaderTest, parseWithHandler) {
+  Json::Reader reader;
+  EventRecorder recorder;
+  std::string document = "// leading comment\n"
+                         "{ \"a\" : [1, -2, 18446744073709551615, 1.5],\n"
+                         "  \"b\\u00e9\" : { \"c\" : null, \"d\" : true },\n"
+                         "  \"e\" : [], \"f\" : false /* trailing */ }";
+  bool ok = reader.parse(
+      document.data(), document.data() + document.size(), recorder);
+  JSONTEST_ASSERT(ok);
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "{ k:a [ i:1 i:-2 u:18446744073709551615 d:1.5 ] k:b\xc3\xa9 { k:c null "
+      "k:d true } k:e [ ] k:f false }",
+      recorder.events);
+
+  EventRecorder stopper;
+  stopper.eventLimit = 4;
+  ok = reader.parse(document.data(), document.data() + document.size(), stopper);
+  JSONTEST_ASSERT(!ok);
+  JSONTEST_ASSERT(reader.good());
+  JSONTEST_ASSERT_STRING_EQUAL("{ k:a [ i:1", stopper.events);
+
+  EventRecorder failing;
+  std::string bad = "[1, 2 3]";
+  ok = reader.parse(bad.data(), bad.data() + bad.size(), failing);
+  JSONTEST_ASSERT(!ok);
+  JSONTEST_ASSERT_STRING_EQUAL("[ i:1 i:2", failing.events);
+  std::vector<Json::Reader::StructuredError> errors =
+      reader.getStructuredErrors();
+  JSONTEST_ASSERT(errors.size() == 1);
+  JSONTEST_ASSERT(errors.at(0).offset_start == 6);
+  JSONTEST_ASSERT(errors.at(0).message ==
+                  "Missing ',' or ']' in array declaration");
+}
+
+JSONTEST_FIXTURE(ReaderTest, parseWithCursor) {
+  std::string document = "{ \"skip\" : { \"x\" : [1, [2, 3]], \"y\" : \"z\" },\n"
+                         "  /* comment */ \"id\" : 42,\n"
+                         "  \"list\" : [ \"a\\u0062\", { \"n\" : null } ],\n"
+                         "  \"flag\" : true }";
+  Json::JsonCursor cursor(document.data(), document.data() + document.size());
+  JSONTEST_ASSERT(cursor.next());
+  JSONTEST_ASSERT(cursor.type() == Json::JsonCursor::tokenObjectBegin);
+  JSONTEST_ASSERT(cursor.depth() == 0);
+
+  std::string name;
+  JSONTEST_ASSERT(cursor.next());
+  JSONTEST_ASSERT(cursor.type() == Json::JsonCursor::tokenKey);
+  JSONTEST_ASSERT(cursor.getString(name));
+  JSONTEST_ASSERT_STRING_EQUAL("skip", name);
+  JSONTEST_ASSERT(cursor.skipValue());
+  JSONTEST_ASSERT(cursor.type() == Json::JsonCursor::tokenObjectEnd);
+  JSONTEST_ASSERT(cursor.depth() == 1);
+
+  JSONTEST_ASSERT(cursor.next());
+  JSONTEST_ASSERT(cursor.getString(name));
+  JSONTEST_ASSERT_STRING_EQUAL("id", name);
+  JSONTEST_ASSERT(cursor.next());
+  JSONTEST_ASSERT(cursor.type() == Json::JsonCursor::tokenNumber);
+  Json::Value id;
+  JSONTEST_ASSERT(cursor.getValue(id));
+  JSONTEST_ASSERT_EQUAL(42, id.asInt());
+#ifndef JSON_VALUE_NO_OFFSETS
+  JSONTEST_ASSERT(id.getOffsetStart() == 68);
+  JSONTEST_ASSERT(id.getOffsetLimit() == 70);
+#endif
+
+  JSONTEST_ASSERT(cursor.next());
+  JSONTEST_ASSERT(cursor.getString(name));
+  JSONTEST_ASSERT_STRING_EQUAL("list", name);
+  JSONTEST_ASSERT(cursor.next());
+  JSONTEST_ASSERT(cursor.type() == Json::JsonCursor::tokenArrayBegin);
+  JSONTEST_ASSERT(cursor.depth() == 1);
+  JSONTEST_ASSERT(cursor.next());
+  JSONTEST_ASSERT(cursor.type() == Json::JsonCursor::tokenString);
+  JSONTEST_ASSERT(cursor.depth() == 2);
+  JSONTEST_ASSERT(cursor.getString(name));
+  JSONTEST_ASSERT_STRING_EQUAL("ab", name);
+  JSONTEST_ASSERT(cursor.next());
+  Json::Value subtree;
+  JSONTEST_ASSERT(cursor.getValue(subtree));
+  JSONTEST_ASSERT(cursor.type() == Json::JsonCursor::tokenObjectEnd);
+  JSONTEST_ASSERT(subtree.isObject());
+  JSONTEST_ASSERT(subtree.isMember("n"));
+  JSONTEST_ASSERT(subtree["n"].isNull());
+  JSONTEST_ASSERT(cursor.next());
+  JSONTEST_ASSERT(cursor.type() == Json::JsonCursor::tokenArrayEnd);
+
+  JSONTEST_ASSERT(cursor.next());
+  JSONTEST_ASSERT(cursor.next());
+  JSONTEST_ASSERT(cursor.type() == Json::JsonCursor::tokenTrue);
+  JSONTEST_ASSERT(cursor.next());
+  JSONTEST_ASSERT(cursor.type() == Json::JsonCursor::tokenObjectEnd);
+  JSONTEST_ASSERT(cursor.depth() == 0);
+  JSONTEST_ASSERT(!cursor.next());
+  JSONTEST_ASSERT(cursor.type() == Json::JsonCursor::tokenEndOfDocument);
+  JSONTEST_ASSERT(cursor.good());
+
+  Json::Features features;
+  features.allowDroppedNullPlaceholders_ = true;
+  std::string holes = "[,1]";
+  Json::JsonCursor dropped(
+      holes.data(), holes.data() + holes.size(), features);
+  JSONTEST_ASSERT(dropped.next());
+  JSONTEST_ASSERT(dropped.type() == Json::JsonCursor::tokenArrayBegin);
+  JSONTEST_ASSERT(dropped.next());
+  JSONTEST_ASSERT(dropped.type() == Json::JsonCursor::tokenNull);
+  JSONTEST_ASSERT(dropped.next());
+  JSONTEST_ASSERT(dropped.type() == Json::JsonCursor::tokenNumber);
+  JSONTEST_ASSERT(dropped.next());
+  JSONTEST_ASSERT(dropped.type() == Json::JsonCursor::tokenArrayEnd);
+  JSONTEST_ASSERT(!dropped.next());
+  JSONTEST_ASSERT(dropped.good());
+
+  // In strict mode, a nested empty container does not allow a trailing comma
+  // after it.
+  const char* trailing[] = { "[1,{},]", "[1,[],]", "{\"a\":{},}" };
+  for (int index = 0; index < 3; ++index) {
+    std::string text = trailing[index];
+    Json::Reader strictReader(Json::Features::strictMode());
+    Json::Value root;
+    JSONTEST_ASSERT(!strictReader.parse(text, root));
+    Json::JsonCursor strict(
+        text.data(), text.data() + text.size(), Json::Features::strictMode());
+    while (strict.next())
+      ;
+    JSONTEST_ASSERT(strict.type() == Json::JsonCursor::tokenError);
+    JSONTEST_ASSERT(!strict.good());
+  }
+
+  // The containers the cursor is in count towards the maximum nesting depth
+  // of getValue().
+  Json::Features shallow;
+  shallow.maxDepth_ = 3;
+  std::string deep = "[[[[1]]]]";
+  Json::JsonCursor limited(deep.data(), deep.data() + deep.size(), shallow);
+  JSONTEST_ASSERT(limited.next());
+  JSONTEST_ASSERT(limited.next());
+  Json::Value nested;
+  JSONTEST_ASSERT(!limited.getValue(nested));
+  JSONTEST_ASSERT(!limited.good());
+  JSONTEST_ASSERT(limited.getStructuredErrors().at(0).message ==
+                  "Exceeded the maximum nesting depth.");
+  deep = "[[[1]]]";
+  Json::JsonCursor enough(deep.data(), deep.data() + deep.size(), shallow);
+  JSONTEST_ASSERT(enough.next());
+  JSONTEST_ASSERT(enough.next());
+  JSONTEST_ASSERT(enough.getValue(nested));
+  JSONTEST_ASSERT_EQUAL(1, nested[0][0].asInt());
+
+  std::string bad = "[1, 2 3]";
+  Json::JsonCursor failing(bad.data(), bad.data() + bad.size());
+  JSONTEST_ASSERT(failing.next());
+  JSONTEST_ASSERT(failing.next());
+  JSONTEST_ASSERT(failing.next());
+  JSONTEST_ASSERT(!failing.next());
+  JSONTEST_ASSERT(failing.type() == Json::JsonCursor::tokenError);
+  JSONTEST_ASSERT(!failing.next());
+  JSONTEST_ASSERT(!failing.good());
+  std::vector<Json::Reader::StructuredError> errors =
+      failing.getStructuredErrors();
+  JSONTEST_ASSERT(errors.size() == 1);
+  JSONTEST_ASSERT(errors.at(0).offset_start == 6);
+  JSONTEST_ASSERT(errors.at(0).message ==
+                  "Missing ',' or ']' in array declaration");
+}
+
+JSONTEST_FIXTURE(ReaderTest, parseIncrementally) {
+  std::string document = "// leading comment\n"
+                         "{ \"a\" : [1, -2, 18446744073709551615, 1.5e3],\n"
+                         "  \"b\\u00e9\" : { \"c\" : null, \"d\" : true },\n"
+                         "  \"e\" : [,\"x\"], \"f\" : false /* trailing */,\n"
+                         "  \"g\" : 1, \"g\" : null }";
+  Json::Value expected;
+  Json::Reader reader;
+  JSONTEST_ASSERT(reader.parse(document, expected, false));
+  // The last duplicate wins, even when it is null.
+  JSONTEST_ASSERT(expected["g"].isNull());
+
+  // Every split of the document into chunks gives the same result.
+  Json::IncrementalReader incremental;
+  for (size_t chunk = 1; chunk <= document.size(); ++chunk) {
+    incremental.reset();
+    for (size_t offset = 0; offset < document.size(); offset += chunk) {
+      size_t length = std::min(chunk, document.size() - offset);
+      JSONTEST_ASSERT(incremental.feed(document.data() + offset, length));
+    }
+    Json::Value root;
+    JSONTEST_ASSERT(incremental.finish(root));
+    JSONTEST_ASSERT(root == expected);
+  }
+
+  // In strict mode, a nested empty container does not allow a trailing comma
+  // after it, however the document is split.
+  const std::string trailing[] = { "[1,{},]", "[1,[],]", "{\"a\":{},}" };
+  Json::IncrementalReader strict(Json::Features::strictMode());
+  for (int index = 0; index < 3; ++index) {
+    const std::string& text = trailing[index];
+    for (size_t chunk = 1; chunk <= text.size(); ++chunk) {
+      strict.reset();
+      bool fed = true;
+      for (size_t offset = 0; fed && offset < text.size(); offset += chunk)
+        fed = strict.feed(text.data() + offset,
+                          std::min(chunk, text.size() - offset));
+      Json::Value root;
+      JSONTEST_ASSERT(!(fed && strict.finish(root)));
+      JSONTEST_ASSERT(!strict.good());
+    }
+  }
+
+  // A number is only complete at the end of the input.
+  incremental.reset();
+  JSONTEST_ASSERT(incremental.feed("12", 2));
+  JSONTEST_ASSERT(incremental.feed("34", 2));
+  Json::Value number;
+  JSONTEST_ASSERT(incremental.finish(number));
+  JSONTEST_ASSERT_EQUAL(1234, number.asInt());
+
+  EventRecorder recorder;
+  Json::IncrementalReader events(recorder);
+  JSONTEST_ASSERT(events.feed("[tr", 3));
+  JSONTEST_ASSERT_STRING_EQUAL("[", recorder.events);
+  JSONTEST_ASSERT(events.feed("ue, \"s", 6));
+  JSONTEST_ASSERT_STRING_EQUAL("[ true", recorder.events);
+  JSONTEST_ASSERT(events.feed("\"]", 2));
+  JSONTEST_ASSERT(events.finish());
+  JSONTEST_ASSERT_STRING_EQUAL("[ true s:s ]", recorder.events);
+
+  incremental.reset();
+  JSONTEST_ASSERT(incremental.feed("[1, 2", 5));
+  JSONTEST_ASSERT(!incremental.feed(" 3]", 3));
+  JSONTEST_ASSERT(!incremental.finish());
+  JSONTEST_ASSERT(!incremental.good());
+  std::vector<Json::Reader::StructuredError> errors =
+      incremental.getStructuredErrors();
+  JSONTEST_ASSERT(errors.size() == 1);
+  JSONTEST_ASSERT(errors.at(0).offset_start == 6);
+  JSONTEST_ASSERT(errors.at(0).offset_limit == 7);
+  JSONTEST_ASSERT(errors.at(0).message ==
+                  "Missing ',' or ']' in array declaration");
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "* Offset 6\n  Missing ',' or ']' in array declaration\n",
+      incremental.getFormattedErrorMessages());
+
+  incremental.reset();
+  JSONTEST_ASSERT(incremental.feed("{\"a\" : \"unterminated", 20));
+  JSONTEST_ASSERT(!incremental.finish());
+  errors = incremental.getStructuredErrors();
+  JSONTEST_ASSERT(errors.size() == 1);
+  JSONTEST_ASSERT(errors.at(0).offset_start == 7);
+  JSONTEST_ASSERT(errors.at(0).message ==
+                  "Syntax error: value, object or array expected.");
+}
+
+JSONTEST_FIXTURE(ReaderTest, parseInSitu) {
+  std::string text = "{ \"plain\" : \"value\", \"esc\\u0061ped\" : "
+                     "[\"tab\\there\", \"\\u00e9\", 12], \"n\" : null }";
+  Json::Value expected;
+  Json::Reader reader;
+  JSONTEST_ASSERT(reader.parse(text, expected));
+
+  std::vector<char> document(text.begin(), text.end());
+  char* begin = &document[0];
+  char* end = begin + document.size();
+  Json::Value root;
+  JSONTEST_ASSERT(reader.parseInSitu(begin, end, root));
+  JSONTEST_ASSERT(reader.good());
+  JSONTEST_ASSERT(root == expected);
+#ifndef JSON_VALUE_NO_OFFSETS
+  JSONTEST_ASSERT(root.getOffsetLimit() == document.size());
+#endif
+
+  // Strings and member names reference the document.
+  const char* plain = root["plain"].asCString();
+  JSONTEST_ASSERT(plain > begin && plain < end);
+  JSONTEST_ASSERT_STRING_EQUAL("value", plain);
+  const char* escaped = root["escaped"][0].asCString();
+  JSONTEST_ASSERT(escaped > begin && escaped < end);
+  JSONTEST_ASSERT_STRING_EQUAL("tab\there", escaped);
+  for (Json::Value::iterator it = root.begin(); it != root.end(); ++it) {
+    const char* name = it.memberName();
+    JSONTEST_ASSERT(name > begin && name < end);
+  }
+
+  // Copies own their strings.
+  Json::Value copy = root["plain"];
+  JSONTEST_ASSERT(copy.asCString() != plain);
+  JSONTEST_ASSERT_STRING_EQUAL("value", copy.asCString());
+
+  std::string bad = "[\"\\x\"]";
+  std::vector<char> badDocument(bad.begin(), bad.end());
+  JSONTEST_ASSERT(!reader.parseInSitu(
+      &badDocument[0], &badDocument[0] + badDocument.size(), root));
+  JSONTEST_ASSERT(reader.getStructuredErrors().size() == 1);
+  JSONTEST_ASSERT(reader.getStructuredErrors().at(0).message ==
+                  "Bad escape sequence in string");
+
+  // A later parse() does not modify its document.
+  std::string constant = "[\"value\"]";
+  JSONTEST_ASSERT(reader.parse(
+      constant.data(), constant.data() + constant.size(), root));
+  JSONTEST_ASSERT_STRING_EQUAL("[\"value\"]", constant);
+}
+
+JSONTEST_FIXTURE(ReaderTest, parseDoubles) {
+  Json::Reader reader;
+  Json::Value root;
+  bool ok = reader.parse("[0.1, 1e23, -2.5E-3, 1.7976931348623157e308, "
+                         "2.2250738585072011e-308, 4.9e-324, 1e-400, "
+                         "9007199254740993.0, 0.30000000000000001665, "
+                         "123456789012345678901234567890, -0.0, 1.]",
+                         root);
+  JSONTEST_ASSERT(ok);
+  // Each value is the double nearest to the decimal number.
+  JSONTEST_ASSERT_EQUAL(0.1, root[0].asDouble());
+  JSONTEST_ASSERT_EQUAL(1e23, root[1].asDouble());
+  JSONTEST_ASSERT_EQUAL(-2.5E-3, root[2].asDouble());
+  JSONTEST_ASSERT_EQUAL(1.7976931348623157e308, root[3].asDouble());
+  JSONTEST_ASSERT_EQUAL(2.2250738585072011e-308, root[4].asDouble());
+  JSONTEST_ASSERT_EQUAL(4.9e-324, root[5].asDouble());
+  JSONTEST_ASSERT_EQUAL(0.0, root[6].asDouble());
+  JSONTEST_ASSERT_EQUAL(9007199254740992.0, root[7].asDouble());
+  JSONTEST_ASSERT_EQUAL(0.30000000000000001665, root[8].asDouble());
+  JSONTEST_ASSERT_EQUAL(1.2345678901234568e29, root[9].asDouble());
+  JSONTEST_ASSERT_EQUAL(0.0, root[10].asDouble());
+  JSONTEST_ASSERT(1.0 / root[10].asDouble() < 0);
+  JSONTEST_ASSERT_EQUAL(1.0, root[11].asDouble());
+
+  ok = reader.parse("[1.5e]", root);
+  JSONTEST_ASSERT(!ok);
+  JSONTEST_ASSERT(reader.getStructuredErrors().size() == 1);
+  JSONTEST_ASSERT(reader.getStructuredErrors().at(0).message ==
+                  "'1.5e' is not a number.");
+  // An exponent needs digits, which sscanf() did not require.
+  JSONTEST_ASSERT(!reader.parse("[0e]", root));
+  JSONTEST_ASSERT(reader.getStructuredErrors().at(0).message ==
+                  "'0e' is not a number.");
+  JSONTEST_ASSERT(!reader.parse("[1e+]", root));
+  JSONTEST_ASSERT(!reader.parse("[1E-]", root));
+  JSONTEST_ASSERT(reader.parse("[1E-0]", root));
+}
+
+JSONTEST_FIXTURE(ReaderTest, parseIntegers) {
+  Json::Reader reader;
+  Json::Value root;
+  bool ok = reader.parse("[0, -0, 12345678, 1234567890123456789, "
+                         "-9223372036854775808, 9223372036854775807, "
+                         "9223372036854775808, 18446744073709551615, "
+                         "18446744073709551616, -9223372036854775809, "
+                         "000000000000000000000042, 123456789012345678901]",
+                         root);
+  JSONTEST_ASSERT(ok);
+  JSONTEST_ASSERT_EQUAL(Json::intValue, root[0].type());
+  JSONTEST_ASSERT_EQUAL(0, root[0].asInt());
+  JSONTEST_ASSERT_EQUAL(Json::intValue, root[1].type());
+  JSONTEST_ASSERT_EQUAL(0, root[1].asInt());
+  JSONTEST_ASSERT_EQUAL(12345678, root[2].asInt());
+#ifdef JSON_HAS_INT64
+  JSONTEST_ASSERT_EQUAL(Json::intValue, root[3].type());
+  JSONTEST_ASSERT_EQUAL(Json::Int64(1234567890123456789LL), root[3].asInt64());
+  JSONTEST_ASSERT_EQUAL(Json::intValue, root[4].type());
+  JSONTEST_ASSERT_EQUAL(Json::Value::minInt64, root[4].asInt64());
+  JSONTEST_ASSERT_EQUAL(Json::intValue, root[5].type());
+  JSONTEST_ASSERT_EQUAL(Json::Value::maxInt64, root[5].asInt64());
+  JSONTEST_ASSERT_EQUAL(Json::uintValue, root[6].type());
+  JSONTEST_ASSERT_EQUAL(Json::UInt64(Json::Value::maxInt64) + 1,
+                        root[6].asUInt64());
+  JSONTEST_ASSERT_EQUAL(Json::uintValue, root[7].type());
+  JSONTEST_ASSERT_EQUAL(Json::Value::maxUInt64, root[7].asUInt64());
+  JSONTEST_ASSERT_EQUAL(Json::realValue, root[8].type());
+  JSONTEST_ASSERT_EQUAL(18446744073709551616.0, root[8].asDouble());
+  JSONTEST_ASSERT_EQUAL(Json::realValue, root[9].type());
+  JSONTEST_ASSERT_EQUAL(-9223372036854775809.0, root[9].asDouble());
+#endif
+  JSONTEST_ASSERT_EQUAL(Json::intValue, root[10].type());
+  JSONTEST_ASSERT_EQUAL(42, root[10].asInt());
+  JSONTEST_ASSERT_EQUAL(Json::realValue, root[11].type());
+  JSONTEST_ASSERT_EQUAL(123456789012345678901.0, root[11].asDouble());
+
+  ok = reader.parse("[-]", root);
+  JSONTEST_ASSERT(!ok);
+  JSONTEST_ASSERT(reader.getStructuredErrors().size() == 1);
+  JSONTEST_ASSERT(reader.getStructuredErrors().at(0).message ==
+                  "'-' is not a number.");
+}
+
+JSONTEST_FIXTURE(ReaderTest, parseWithStrictReader) {
+  const char* documents[] = {
+    "{ \"a\": [1, 2.5, \"x\", true, null], \"b\": {} }",
+    "[1, 2, 3]",
+    "[1, 2, 3] // comment",
+    "/* comment */ [1]",
+    "42",
+    "\"string\"",
+    "[1, , 3]",
+    "[1, 2, ]",
+    "{ 1: true }",
+    "{ \"a\": 1, }"
+  };
+  for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); ++i) {
+    Json::StrictReader strict;
+    Json::Reader reader(Json::Features::strictMode());
+    Json::Value strictRoot;
+    Json::Value root;
+    bool strictOk = strict.parse(documents[i], strictRoot);
+    bool ok = reader.parse(documents[i], root);
+    JSONTEST_ASSERT_EQUAL(ok, strictOk) << documents[i];
+    JSONTEST_ASSERT(root == strictRoot) << documents[i];
+    JSONTEST_ASSERT_STRING_EQUAL(reader.getFormattedErrorMessages(),
+                                 strict.getFormattedErrorMessages());
+  }
+
+  Json::StrictReader strict;
+  Json::Value root;
+  JSONTEST_ASSERT(strict.parse("[1, 2]", root));
+  JSONTEST_ASSERT_EQUAL(2, root.size());
+  JSONTEST_ASSERT(!strict.parse("1", root));
+  JSONTEST_ASSERT(!strict.parse("/* comment */ [1]", root));
+}
+
+JSONTEST_FIXTURE(ReaderTest, parseWithMaxDepth) {
+  Json::Features features;
+  features.maxDepth_ = 3;
+  Json::Reader reader(features);
+  Json::Value root;
+  JSONTEST_ASSERT(reader.parse("[{\"a\": [1]}, [2]]", root));
+  JSONTEST_ASSERT_EQUAL(1, root[0u]["a"][0u].asInt());
+  JSONTEST_ASSERT(!reader.parse("[{\"a\": [[1]]}]", root));
+  std::vector<Json::Reader::StructuredError> errors =
+      reader.getStructuredErrors();
+  JSONTEST_ASSERT(errors.size() == 1);
+  JSONTEST_ASSERT(errors.at(0).offset_start == 8);
+  JSONTEST_ASSERT(errors.at(0).message ==
+                  "Exceeded the maximum nesting depth.");
+
+  // Far deeper than a recursive parser could go on a thread stack.
+  std::string deep(1000000, '[');
+  deep.append(1000000, ']');
+  Json::Reader defaultReader;
+  JSONTEST_ASSERT(!defaultReader.parse(deep, root));
+  JSONTEST_ASSERT(defaultReader.getStructuredErrors().at(0).offset_start ==
+                  1000);
+  Json::ReaderHandler handler;
+  JSONTEST_ASSERT(!defaultReader.parse(
+      deep.data(), deep.data() + deep.size(), handler));
+
+  features.maxDepth_ = 2000000;
+  Json::Reader deepReader(features);
+  JSONTEST_ASSERT(deepReader.parse(deep.data(), deep.data() + deep.size(),
+                                   handler));
+  // Destroying a Value is recursive, so keep the tree shallower.
+  std::string tree(20000, '[');
+  tree.append(20000, ']');
+  JSONTEST_ASSERT(deepReader.parse(tree, root));
+
+  Json::IncrementalReader incremental;
+  JSONTEST_ASSERT(!incremental.feed(deep.data(), deep.size()));
+  Json::JsonCursor cursor(deep.data(), deep.data() + deep.size());
+  while (cursor.next()) {
+  }
+  JSONTEST_ASSERT(!cursor.good());
+}
+
+JSONTEST_FIXTURE(ReaderTest, parseFile) {
+  const char* path = "jsoncpp_test_parse_file.json";
+  const std::string text = "{ \"property\" : [\"value\", 12] }";
+  FILE* file = fopen(path, "wb");
+  JSONTEST_ASSERT(file != 0);
+  fwrite(text.data(), 1, text.size(), file);
+  fclose(file);
+
+  Json::Reader reader;
+  Json::Value root;
+  JSONTEST_ASSERT(reader.parseFile(path, root));
+  JSONTEST_ASSERT_STRING_EQUAL("value", root["property"][0u].asString());
+#ifndef JSON_VALUE_NO_OFFSETS
+  JSONTEST_ASSERT(root["property"].getOffsetStart() == 15);
+  JSONTEST_ASSERT(root["property"].getOffsetLimit() == 28);
+#endif
+
+  Json::MappedDocument document;
+  JSONTEST_ASSERT(document.open(path));
+  JSONTEST_ASSERT(document.size() == text.size());
+  JSONTEST_ASSERT(std::string(document.begin(), document.end()) == text);
+  Json::MappedDocument copy(document);
+  document.close();
+  JSONTEST_ASSERT(!document.isOpen());
+  JSONTEST_ASSERT(copy.isOpen());
+  JSONTEST_ASSERT(reader.parse(copy.begin(), copy.end(), root));
+  JSONTEST_ASSERT_EQUAL(12, root["property"][1u].asInt());
+  copy.close();
+  remove(path);
+
+  JSONTEST_ASSERT(!document.open(path));
+  JSONTEST_ASSERT(!reader.parseFile(path, root));
+  JSONTEST_ASSERT(reader.getStructuredErrors().size() == 1);
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "Unable to map file 'jsoncpp_test_parse_file.json'.",
+      reader.getStructuredErrors().at(0).message);
+}
+
+JSONTEST_FIXTURE(ReaderTest, parseLines) {
+  std::string input = "{\"id\": 0}\n"
+                      "\n"
+                      "[1, 2]\r\n"
+                      "{\"id\": }\n"
+                      "  \t\n"
+                      "\"last\"";
+  Json::LinesReader reader(Json::Features::all(), 1);
+  std::vector<Json::Value> records;
+  JSONTEST_ASSERT(!reader.parse(input.data(), input.data() + input.size(),
+                                records));
+  JSONTEST_ASSERT_EQUAL(4, records.size());
+  JSONTEST_ASSERT_EQUAL(0, records[0]["id"].asInt());
+  JSONTEST_ASSERT_EQUAL(2, records[1][1u].asInt());
+  JSONTEST_ASSERT(records[2].isNull());
+  JSONTEST_ASSERT_STRING_EQUAL("last", records[3].asString());
+  std::vector<Json::LinesReader::StructuredError> errors =
+      reader.getStructuredErrors();
+  JSONTEST_ASSERT(errors.size() == 1);
+  JSONTEST_ASSERT(errors.at(0).record == 2);
+  JSONTEST_ASSERT(errors.at(0).line == 4);
+  JSONTEST_ASSERT(errors.at(0).offset_start == 26);
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "* Line 4, Offset 26\n  Syntax error: value, object or array expected.\n",
+      reader.getFormattedErrorMessages());
+
+  // Enough lines for several blocks, parsed by several threads.
+  std::string lines;
+  for (int index = 0; index < 100000; ++index) {
+    std::ostringstream line;
+    line << "{\"index\": " << index << ", \"tags\": [\"a\", \"b\"]}\n";
+    lines += line.str();
+  }
+  lines += "[\n";
+  Json::LinesReader threaded(Json::Features::all(), 4);
+  JSONTEST_ASSERT(!threaded.parse(lines.data(), lines.data() + lines.size(),
+                                  records));
+  JSONTEST_ASSERT_EQUAL(100001, records.size());
+  for (int index = 0; index < 100000; ++index)
+    JSONTEST_ASSERT_EQUAL(index, records[index]["index"].asInt());
+  errors = threaded.getStructuredErrors();
+  JSONTEST_ASSERT(errors.size() == 1);
+  JSONTEST_ASSERT(errors.at(0).record == 100000);
+  JSONTEST_ASSERT(errors.at(0).line == 100001);
+}
+
+static void collectOffsets(const Json::Value& value,
+                           std::vector<size_t>& offsets) {
+  offsets.push_back(value.getOffsetStart());
+  offsets.push_back(value.getOffsetLimit());
+  for (Json::Value::const_iterator it = value.begin(); it != value.end(); ++it)
+    collectOffsets(*it, offsets);
+}
+
+JSONTEST_FIXTURE(ReaderTest, parseInParallel) {
+  // Large enough to be cut into blocks.
+  std::string document = "/* leading */ [";
+  for (int index = 0; index < 50000; ++index) {
+    std::ostringstream element;
+    element << (index ? ",\n" : "") << "{\"id\": " << index
+            << ", \"name\": \"a \\\"quoted\\\" ], name\", \"v\": [1.5, "
+            << "// ] comment\n"
+            << "true]}";
+    document += element.str();
+  }
+  document += "]";
+  const char* begin = document.data();
+  const char* end = begin + document.size();
+
+  Json::Reader reader;
+  Json::Value expected;
+  JSONTEST_ASSERT(reader.parse(begin, end, expected, false));
+  Json::ParallelReader parallel(Json::Features::all(), 4);
+  Json::Value root;
+  JSONTEST_ASSERT(parallel.parse(begin, end, root));
+  JSONTEST_ASSERT(parallel.good());
+  JSONTEST_ASSERT_EQUAL(50000, root.size());
+  JSONTEST_ASSERT(root == expected);
+  std::vector<size_t> expectedOffsets;
+  std::vector<size_t> offsets;
+  collectOffsets(expected, expectedOffsets);
+  collectOffsets(root, offsets);
+  JSONTEST_ASSERT(offsets == expectedOffsets);
+
+  // Errors are those of Reader.
+  document[document.size() / 2] = '}';
+  begin = document.data();
+  end = begin + document.size();
+  JSONTEST_ASSERT(!reader.parse(begin, end, expected, false));
+  JSONTEST_ASSERT(!parallel.parse(begin, end, root));
+  JSONTEST_ASSERT_STRING_EQUAL(reader.getFormattedErrorMessages(),
+                               parallel.getFormattedErrorMessages());
+}
+
+JSONTEST_FIXTURE(ReaderTest, parseLazily) {
+  const std::string document =
+      "{ \"name\": \"lazy\", \"count\": 3, \"name\": \"last\",\n"
+      "  \"items\": [ 1, -2, 3.5, true, null, { \"a\": [] } ],\n"
+      "  // comment\n"
+      "  \"empty\": {} }";
+  Json::LazyDocument lazy;
+  JSONTEST_ASSERT(lazy.parse(document));
+  JSONTEST_ASSERT(lazy.good());
+  Json::Reader reader;
+  Json::Value expected;
+  JSONTEST_ASSERT(reader.parse(document, expected));
+
+  Json::LazyValue root = lazy.root();
+  JSONTEST_ASSERT_EQUAL(Json::objectValue, root.type());
+  JSONTEST_ASSERT_EQUAL(5, root.size());
+  JSONTEST_ASSERT(root.isMember("count"));
+  JSONTEST_ASSERT(!root.isMember("missing"));
+  JSONTEST_ASSERT_EQUAL(Json::nullValue, root["missing"].type());
+  JSONTEST_ASSERT(root["missing"].value().isNull());
+  JSONTEST_ASSERT_STRING_EQUAL("last", root["name"].value().asString());
+  // Members are listed as written, duplicates included.
+  JSONTEST_ASSERT_EQUAL(5, root.getMemberNames().size());
+  JSONTEST_ASSERT_STRING_EQUAL("name", root.getMemberNames()[2]);
+
+  Json::LazyValue items = root["items"];
+  JSONTEST_ASSERT_EQUAL(Json::arrayValue, items.type());
+  JSONTEST_ASSERT_EQUAL(6, items.size());
+  JSONTEST_ASSERT_EQUAL(Json::intValue, items[1].type());
+  JSONTEST_ASSERT_EQUAL(-2, items[1].value().asInt());
+  JSONTEST_ASSERT_EQUAL(Json::realValue, items[2].type());
+  JSONTEST_ASSERT_EQUAL(Json::objectValue, items[5].type());
+  JSONTEST_ASSERT_EQUAL(Json::arrayValue, items[5]["a"].type());
+  JSONTEST_ASSERT_EQUAL(Json::nullValue, items[6].type());
+  JSONTEST_ASSERT_EQUAL(Json::nullValue, items[-1].type());
+  JSONTEST_ASSERT(items.value() == expected["items"]);
+  JSONTEST_ASSERT(root.value() == expected);
+  JSONTEST_ASSERT(root["empty"].begin() == root["empty"].end());
+
+  // Iteration visits the values in document order.
+  Json::ArrayIndex count = 0;
+  for (Json::LazyValue::const_iterator it = items.begin(); it != items.end();
+       ++it, ++count)
+    JSONTEST_ASSERT((*it).value() == expected["items"][count]);
+  JSONTEST_ASSERT_EQUAL(6, count);
+  std::vector<std::string> names;
+  for (Json::LazyValue::const_iterator it = root.begin(); it != root.end();
+       ++it)
+    names.push_back(it.name());
+  JSONTEST_ASSERT_EQUAL(5, names.size());
+  JSONTEST_ASSERT_STRING_EQUAL("name", names[0]);
+  JSONTEST_ASSERT_STRING_EQUAL("empty", names[4]);
+
+#ifndef JSON_VALUE_NO_OFFSETS
+  // Offsets are those Reader records.
+  JSONTEST_ASSERT_EQUAL(expected["items"].getOffsetStart(),
+                        items.getOffsetStart());
+  JSONTEST_ASSERT_EQUAL(expected["items"].getOffsetLimit(),
+                        items.getOffsetLimit());
+#endif
+  JSONTEST_ASSERT_EQUAL(expected["items"][5].getOffsetStart(),
+                        items[5].value().getOffsetStart());
+
+  // Names with escapes are decoded to be compared; numeric names as Reader
+  // converts them.
+  JSONTEST_ASSERT(
+      lazy.parse("{ \"t\\u0061b\": [1], 7: \"seven\", \"tab\": [,] }"));
+  root = lazy.root();
+  JSONTEST_ASSERT_EQUAL(1, root["tab"].size());
+  JSONTEST_ASSERT_STRING_EQUAL("tab", root.getMemberNames()[0]);
+  JSONTEST_ASSERT_STRING_EQUAL("seven", root["7"].value().asString());
+  // Dropped nulls and trailing commas, as Reader reads them.
+  JSONTEST_ASSERT(lazy.parse("[1,,2,]"));
+  JSONTEST_ASSERT(reader.parse("[1,,2,]", expected));
+  JSONTEST_ASSERT_EQUAL(3, lazy.root().size());
+  JSONTEST_ASSERT_EQUAL(Json::nullValue, lazy.root()[1].type());
+  JSONTEST_ASSERT(lazy.root()[1].value().isNull());
+  JSONTEST_ASSERT(lazy.root().value() == expected);
+  // A scalar root.
+  JSONTEST_ASSERT(lazy.parse(" \"text\" "));
+  JSONTEST_ASSERT_EQUAL(Json::stringValue, lazy.root().type());
+  JSONTEST_ASSERT_STRING_EQUAL("text", lazy.root().value().asString());
+  JSONTEST_ASSERT_EQUAL(0, lazy.root().size());
+
+  // Errors are those of Reader.
+  const std::string invalid = "{ \"a\": [1, 2 }";
+  JSONTEST_ASSERT(!lazy.parse(invalid));
+  JSONTEST_ASSERT(!reader.parse(invalid, expected));
+  JSONTEST_ASSERT(!lazy.good());
+  JSONTEST_ASSERT_STRING_EQUAL(reader.getFormattedErrorMessages(),
+                               lazy.getFormattedErrorMessages());
+  JSONTEST_ASSERT_EQUAL(Json::nullValue, lazy.root().type());
+}
+
+JSONTEST_FIXTURE(ReaderTest, parseSelectedPaths) {
+  const std::string document =
+      "{ \"body\": [ 1, { \"x\": 2, \"y\": [3] }, 4 ],\n"
+      "  // comment\n"
+      "  \"header\": { \"id\": 7, \"route\": \"a\" },\n"
+      "  \"header\": { \"id\": 8 } }";
+  const char* begin = document.data();
+  const char* end = begin + document.size();
+  Json::Reader reader;
+  Json::Value expected;
+  JSONTEST_ASSERT(reader.parse(begin, end, expected, false));
+
+  std::vector<Json::Path> paths;
+  paths.push_back(Json::Path(".body[1].x"));
+  paths.push_back(Json::Path(".header.route"));
+  paths.push_back(Json::Path(".missing"));
+  paths.push_back(Json::Path(".body[7]"));
+  Json::Value root;
+  JSONTEST_ASSERT(reader.parse(begin, end, paths, root));
+  JSONTEST_ASSERT(reader.good());
+  JSONTEST_ASSERT_EQUAL(2, root.size());
+  JSONTEST_ASSERT_EQUAL(2, root["body"][1]["x"].asInt());
+  JSONTEST_ASSERT(!root["body"][1].isMember("y"));
+  JSONTEST_ASSERT_EQUAL(2, root["body"].size());
+  // The first of the duplicate members is read.
+  JSONTEST_ASSERT_STRING_EQUAL("a", root["header"]["route"].asString());
+  JSONTEST_ASSERT_EQUAL(expected["body"][1]["x"].getOffsetStart(),
+                        root["body"][1]["x"].getOffsetStart());
+
+  paths.assign(1, Json::Path("."));
+  JSONTEST_ASSERT(reader.parse(begin, end, paths, root));
+  JSONTEST_ASSERT(root == expected);
+
+  // Parsing stops once the selected values are read.
+  const std::string truncated = "{ \"header\": { \"id\": 7 }, \"body\": [1, 2";
+  begin = truncated.data();
+  end = begin + truncated.size();
+  paths.assign(1, Json::Path(".header"));
+  JSONTEST_ASSERT(reader.parse(begin, end, paths, root));
+  JSONTEST_ASSERT_EQUAL(1, root.size());
+  JSONTEST_ASSERT_EQUAL(7, root["header"]["id"].asInt());
+  paths.push_back(Json::Path(".missing"));
+  JSONTEST_ASSERT(!reader.parse(begin, end, paths, root));
+
+  // Skipped values are validated.
+  const std::string invalid = "{ \"skip\": [1 2], \"header\": 1 }";
+  begin = invalid.data();
+  end = begin + invalid.size();
+  paths.assign(1, Json::Path(".header"));
+  JSONTEST_ASSERT(!reader.parse(begin, end, paths, root));
+  const std::string errors = reader.getFormattedErrorMessages();
+  JSONTEST_ASSERT(!reader.parse(begin, end, expected));
+  JSONTEST_ASSERT_STRING_EQUAL(reader.getFormattedErrorMessages(), errors);
+
+  // The containers above a selected or skipped value count towards the
+  // maximum nesting depth.
+  Json::Features shallow;
+  shallow.maxDepth_ = 3;
+  Json::Reader limited(shallow);
+  const std::string deep = "{ \"a\": { \"b\": [[1]], \"c\": [[2]] } }";
+  begin = deep.data();
+  end = begin + deep.size();
+  JSONTEST_ASSERT(!limited.parse(begin, end, expected));
+  paths.assign(1, Json::Path(".a.b"));
+  JSONTEST_ASSERT(!limited.parse(begin, end, paths, root));
+  JSONTEST_ASSERT(limited.getStructuredErrors().at(0).message ==
+                  "Exceeded the maximum nesting depth.");
+  paths.assign(1, Json::Path(".a.c[0]"));
+  JSONTEST_ASSERT(!limited.parse(begin, end, paths, root));
+  JSONTEST_ASSERT(limited.getStructuredErrors().at(0).message ==
+                  "Exceeded the maximum nesting depth.");
+  shallow.maxDepth_ = 4;
+  Json::Reader enough(shallow);
+  JSONTEST_ASSERT(enough.parse(begin, end, paths, root));
+  JSONTEST_ASSERT_EQUAL(2, root["a"]["c"][0][0].asInt());
+}
+
+JSONTEST_FIXTURE(ReaderTest, validate) {
+  Json::Reader reader;
+  Json::Value root;
+  const std::string valid =
+      "/* comment */ { \"a\": [1, -2.5e3, \"x\\u00e9\\ud834\\udd1e\\n\"],\n"
+      "  // comment\n"
+      "  \"b\": { \"c\": null, \"d\": [true, false] } }";
+  JSONTEST_ASSERT(reader.validate(valid.data(), valid.data() + valid.size()));
+  JSONTEST_ASSERT(reader.good());
+
+  // The errors are those parse() reports.
+  const char* invalid[] = {
+    "[1, 2",                 "{\"a\" 1}",              "[1 2]",
+    "[\"\\x\"]",             "[\"\\u12\"]",            "[\"\\udd1e\"]",
+    "[\"\\ud834x\"]",        "[\"\\ud834\\ud834\"]",   "[-]",
+    "[1.5e]",                "[tru]",                  "[/* unterminated ]",
+    "{\"a\": [1, 2}"
+  };
+  Json::Reader strict(Json::Features::strictMode());
+  for (size_t index = 0; index < sizeof(invalid) / sizeof(*invalid); ++index) {
+    const std::string document = invalid[index];
+    const char* begin = document.data();
+    const char* end = begin + document.size();
+    JSONTEST_ASSERT(!reader.parse(begin, end, root));
+    const std::string expected = reader.getFormattedErrorMessages();
+    JSONTEST_ASSERT(!reader.validate(begin, end)) << document;
+    JSONTEST_ASSERT_STRING_EQUAL(expected, reader.getFormattedErrorMessages());
+    JSONTEST_ASSERT(!strict.validate(begin, end)) << document;
+  }
+
+  // Features are honoured.
+  const char* lenient[] = { "{1: 2}", "[1,,2]", "1", "// comment\n[1]" };
+  Json::StrictReader strictReader;
+  for (size_t index = 0; index < sizeof(lenient) / sizeof(*lenient); ++index) {
+    const std::string document = lenient[index];
+    const char* begin = document.data();
+    const char* end = begin + document.size();
+    JSONTEST_ASSERT(reader.validate(begin, end)) << document;
+    JSONTEST_ASSERT(!strictReader.validate(begin, end)) << document;
+  }
+}
+
+JSONTEST_FIXTURE(ReaderTest, parseInvalidUTF8) {
+  const std::string document = "[\"caf\xc3\xa9\", \"ab\xe2\x82\"]";
+  Json::Value root;
+  Json::Reader reader;
+  JSONTEST_ASSERT(reader.parse(document, root));
+  JSONTEST_ASSERT_STRING_EQUAL("ab\xe2\x82", root[1].asString());
+
+  Json::Features features = Json::Features::all();
+  features.allowInvalidUTF8_ = false;
+  Json::Reader strict(features);
+  JSONTEST_ASSERT(!strict.parse(document, root));
+  std::vector<Json::Reader::StructuredError> errors =
+      strict.getStructuredErrors();
+  JSONTEST_ASSERT(errors.size() == 1);
+  JSONTEST_ASSERT(errors.at(0).offset_start == 10);
+  JSONTEST_ASSERT(errors.at(0).offset_limit == 16);
+  JSONTEST_ASSERT_STRING_EQUAL("Invalid UTF-8 sequence in string",
+                               errors.at(0).message);
+  const char* begin = document.data();
+  JSONTEST_ASSERT(!strict.validate(begin, begin + document.size()));
+
+  // Overlong forms, surrogates, code points above U+10FFFF and stray bytes
+  // are rejected, in short strings and in long ones.
+  const char* invalid[] = { "\xc0\xaf", "\xed\xa0\x80", "\xf4\x90\x80\x80",
+                            "\x80", "\xff", "\xf0\x9f\x98" };
+  const std::string padding(37, 'x');
+  for (size_t index = 0; index < sizeof(invalid) / sizeof(*invalid); ++index) {
+    const std::string text = invalid[index];
+    JSONTEST_ASSERT(!strict.parse("\"" + text + "\"", root)) << text;
+    JSONTEST_ASSERT(!strict.parse("\"" + padding + text + padding + "\"", root))
+        << text;
+    JSONTEST_ASSERT(reader.parse("\"" + text + "\"", root)) << text;
+  }
+
+  // Escapes are decoded into valid UTF-8.
+  const std::string valid = "\"\xf0\x9f\x98\x80 \\u00e9\\u20ac\\ud83d\\ude00" +
+                            padding + "\xe2\x82\xac\"";
+  JSONTEST_ASSERT(strict.parse(valid, root));
+  JSONTEST_ASSERT_STRING_EQUAL("\xf0\x9f\x98\x80 \xc3\xa9\xe2\x82\xac"
+                               "\xf0\x9f\x98\x80" + padding + "\xe2\x82\xac",
+                               root.asString());
+  std::string inSitu = valid;
+  JSONTEST_ASSERT(strict.parseInSitu(&inSitu[0], &inSitu[0] + inSitu.size(),
+                                     root));
+}
+
+JSONTEST_FIXTURE(ReaderTest, parseStringsIntoValues) {
+  Json::Reader reader(Json::Features::all());
+  Json::Value root;
+  const std::string document = "{ \"a\\tb\": \"x\\u00e9y\\\"\", \"\": \"\", "
+                               "\"k\": 1, 2: \"two\", \"k\": [\"\\n\"] }";
+  JSONTEST_ASSERT(reader.parse(document, root));
+  JSONTEST_ASSERT_EQUAL(4u, root.size());
+  JSONTEST_ASSERT_STRING_EQUAL("x\xc3\xa9y\"", root["a\tb"].asString());
+  JSONTEST_ASSERT(root.isMember(""));
+  JSONTEST_ASSERT_STRING_EQUAL("", root[""].asString());
+  JSONTEST_ASSERT_STRING_EQUAL("two", root["2"].asString());
+  // The last of duplicate keys wins, and its name is not leaked.
+  JSONTEST_ASSERT_STRING_EQUAL("\n", root["k"][0u].asString());
+#ifndef JSON_VALUE_NO_OFFSETS
+  JSONTEST_ASSERT_EQUAL(document.find("\"\\n"),
+                        size_t(root["k"][0u].getOffsetStart()));
+#endif
+
+  // Keys and strings survive copies of the tree.
+  Json::Value copy = root;
+  root = Json::Value();
+  JSONTEST_ASSERT_STRING_EQUAL("x\xc3\xa9y\"", copy["a\tb"].asString());
+
+  // In situ, strings are decoded in place over the document.
+  std::string inSitu = document;
+  JSONTEST_ASSERT(reader.parseInSitu(&inSitu[0], &inSitu[0] + inSitu.size(),
+                                     root));
+  JSONTEST_ASSERT(copy == root);
+  JSONTEST_ASSERT_STRING_EQUAL("a\tb", root.getMemberNames().at(2));
+
+  JSONTEST_ASSERT(!reader.parse("{ \"a\\x\": 1 }", root));
+  JSONTEST_ASSERT(!reader.parse("{ \"a\" 1 }", root));
+  JSONTEST_ASSERT(!reader.parse("[\"\\ud800x\"]", root));
+}
+
+JSONTEST_FIXTURE(ReaderTest, reuseReader) {
+  Json::Reader reader;
+  Json::Value root;
+  // Comments queued by a failed parse are not carried over to the next one.
+  JSONTEST_ASSERT(!reader.parse("[ 1, // one\n", root));
+  JSONTEST_ASSERT(reader.parse("[ 2 ]", root));
+  JSONTEST_ASSERT(!root[0u].hasComment(Json::commentBefore));
+  JSONTEST_ASSERT(!root.hasComment(Json::commentAfter));
+  JSONTEST_ASSERT(reader.parse("[ 1, // one\n 2 ]", root));
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "// one", root[0u].getComment(Json::commentAfterOnSameLine));
+
+  std::istringstream first("{ \"a\": [1, 2] }");
+  JSONTEST_ASSERT(reader.parse(first, root));
+  std::istringstream second("[3]");
+  JSONTEST_ASSERT(reader.parse(second, root));
+  JSONTEST_ASSERT_EQUAL(3, root[0u].asInt());
+#ifndef JSON_VALUE_NO_OFFSETS
+  JSONTEST_ASSERT_EQUAL(Json::Value::UInt(3), root.getOffsetLimit());
+#endif
+
+  JSONTEST_ASSERT(!reader.parse("[ x ]", root));
+  JSONTEST_ASSERT(!reader.good());
+  reader.reset();
+  JSONTEST_ASSERT(reader.good());
+  JSONTEST_ASSERT(reader.getStructuredErrors().empty());
+  JSONTEST_ASSERT_STRING_EQUAL("", reader.getFormattedErrorMessages());
+  JSONTEST_ASSERT(reader.parse("{ \"b\": \"\\n\" }", root));
+  JSONTEST_ASSERT_STRING_EQUAL("\n", root["b"].asString());
+  reader.reset();
+  reader.reset();
+}
+
+JSONTEST_FIXTURE(ReaderTest, parseInto) {
+  Json::Reader reader;
+  Json::Value root;
+  JSONTEST_ASSERT(reader.parseInto(
+      "{ \"name\": \"alpha\", \"items\": [1, {\"x\": true}], \"n\": 1 }",
+      root));
+  Json::Value* item = &root["items"][1u];
+  const char* name = root["name"].asCString();
+
+  // Documents of the same shape update the tree in place.
+  JSONTEST_ASSERT(reader.parseInto(
+      "{ \"n\": 2.5, \"items\": [7, {\"x\": false}], \"name\": \"b\\ta\" }",
+      root));
+  JSONTEST_ASSERT_EQUAL(item, &root["items"][1u]);
+  JSONTEST_ASSERT_EQUAL(name, root["name"].asCString());
+  JSONTEST_ASSERT_STRING_EQUAL("b\ta", root["name"].asString());
+  JSONTEST_ASSERT_EQUAL(2.5, root["n"].asDouble());
+  JSONTEST_ASSERT_EQUAL(false, root["items"][1u]["x"].asBool());
+
+  // Whatever changed, the tree ends up as a fresh parse would build it.
+  const char* documents[] = {
+    "{ \"name\": \"a much longer name\", \"items\": [7] }",
+    "{ \"items\": [7, 8, [9], {}], \"name\": {\"first\": \"c\"} }",
+    "{ \"items\": {\"0\": 1}, \"name\": {}, \"n\": null }",
+    "{ \"n\": 1, \"n\": 2, \"items\": [], \"m\": \"\" }",
+    "[ {\"n\": 1}, \"s\" ]",
+    "\"scalar\""
+  };
+  for (size_t index = 0; index < sizeof(documents) / sizeof(*documents);
+       ++index) {
+    Json::Value expected;
+    JSONTEST_ASSERT(reader.parse(documents[index], expected));
+    JSONTEST_ASSERT(reader.parseInto(documents[index], root));
+    JSONTEST_ASSERT(expected == root) << documents[index];
+    JSONTEST_ASSERT_EQUAL(expected.getOffsetLimit(), root.getOffsetLimit());
+  }
+
+  // The comments of the values kept are those of the last document.
+  JSONTEST_ASSERT(reader.parseInto("// a\n[ 1, // b\n 2 ]", root));
+  JSONTEST_ASSERT_STRING_EQUAL("// a", root.getComment(Json::commentBefore));
+  JSONTEST_ASSERT(reader.parseInto("[ 3, 4 ]", root));
+  JSONTEST_ASSERT(!root.hasComment(Json::commentBefore));
+  JSONTEST_ASSERT(!root[0u].hasComment(Json::commentAfterOnSameLine));
+  JSONTEST_ASSERT_EQUAL(4, root[1].asInt());
+
+  JSONTEST_ASSERT(!reader.parseInto("[ 5, x ]", root));
+  JSONTEST_ASSERT(reader.parseInto("[ 6 ]", root, false));
+  JSONTEST_ASSERT_EQUAL(1u, root.size());
+  JSONTEST_ASSERT_EQUAL(6, root[0u].asInt());
+}
+
+JSONTEST_FIXTURE(ReaderTest, parseWithoutOffsets) {
+  const std::string document = "{ \"a\": [1, \"s\", {}], \"b\": null }";
+  Json::Value root;
+  Json::Reader reader;
+  JSONTEST_ASSERT(reader.parse(document, root));
+
+  Json::Features features;
+  features.storeOffsets_ = false;
+  Json::Reader noOffsets(features);
+  JSONTEST_ASSERT(noOffsets.parseInto(document, root));
+  Json::Value expected;
+  JSONTEST_ASSERT(noOffsets.parse(document, expected));
+  JSONTEST_ASSERT(expected == root);
+  const Json::Value* values[] = { &root, &root["a"], &root["a"][1],
+                                  &root["a"][2], &root["b"], &expected["a"] };
+  for (size_t index = 0; index < sizeof(values) / sizeof(*values); ++index) {
+    JSONTEST_ASSERT_EQUAL(0u, values[index]->getOffsetStart());
+    JSONTEST_ASSERT_EQUAL(0u, values[index]->getOffsetLimit());
+  }
+  JSONTEST_ASSERT(!noOffsets.parse("[1, [2, x]]", root));
+  JSONTEST_ASSERT_EQUAL(Json::Value::UInt(0), root[1].getOffsetLimit());
+}
+
+JSONTEST_FIXTURE(ReaderTest, shareKeys) {
+  Json::KeyTable keys;
+  const char* id = keys.intern("id");
+  const std::string binary("i\0d", 3);
+  JSONTEST_ASSERT(keys.intern("id") == id);
+  JSONTEST_ASSERT(keys.intern(id, id + 2) == id);
+  JSONTEST_ASSERT(keys.intern(binary.data(), binary.data() + 3) != id);
+  JSONTEST_ASSERT_EQUAL(2u, keys.size());
+  // Interned names stay where they are as the table grows.
+  std::vector<const char*> interned;
+  for (int index = 0; index < 100; ++index)
+    interned.push_back(keys.intern(Json::valueToString(index).c_str()));
+  JSONTEST_ASSERT_EQUAL(102u, keys.size());
+  JSONTEST_ASSERT(keys.intern("id") == id);
+  for (int index = 0; index < 100; ++index)
+    JSONTEST_ASSERT(keys.intern(Json::valueToString(index).c_str()) ==
+                    interned[index]);
+
+  // The members read are named with the interned names.
+  const std::string document = "[{\"id\": 1, \"name\": \"a\", \"7\": 0}, "
+                               "{\"name\": \"b\", \"id\": 2, \"7\": 1}]";
+  Json::Reader reader;
+  reader.setKeyTable(&keys);
+  Json::Value root;
+  JSONTEST_ASSERT(reader.parse(document, root));
+  const char* name = keys.intern("name");
+  const Json::Value& records = root;
+  for (Json::ArrayIndex index = 0; index < 2; ++index) {
+    Json::Value::const_iterator it = records[index].begin();
+    JSONTEST_ASSERT(it.memberName() == interned[7]);
+    ++it;
+    JSONTEST_ASSERT(it.memberName() == id);
+    ++it;
+    JSONTEST_ASSERT(it.memberName() == name);
+    JSONTEST_ASSERT_EQUAL(int(index) + 1,
+                          root[index][Json::StaticString(id)].asInt());
+  }
+  JSONTEST_ASSERT_EQUAL(103u, keys.size());
+  Json::Value copy(root);
+  JSONTEST_ASSERT(copy[1].begin().memberName() == interned[7]);
+  JSONTEST_ASSERT(copy == root);
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "[{\"7\":0,\"id\":1,\"name\":\"a\"},{\"7\":1,\"id\":2,\"name\":\"b\"}]\n",
+      Json::FastWriter().write(root));
+
+  // parseInto() names the members it adds with the interned names too.
+  JSONTEST_ASSERT(reader.parseInto("[{\"id\": 3, \"tag\": true}]", root));
+  JSONTEST_ASSERT_EQUAL(1u, root.size());
+  JSONTEST_ASSERT_EQUAL(2u, root[0].size());
+  JSONTEST_ASSERT_EQUAL(3, root[0]["id"].asInt());
+  Json::Value::const_iterator it = records[0].begin();
+  JSONTEST_ASSERT(it.memberName() == id);
+  JSONTEST_ASSERT((++it).memberName() == keys.intern("tag"));
+
+  // Without a table, the members have names of their own.
+  reader.setKeyTable(0);
+  JSONTEST_ASSERT(reader.parse(document, root));
+  JSONTEST_ASSERT(root[0].begin().memberName() != interned[7]);
+  JSONTEST_ASSERT(root == copy);
+}
+
 int main(int argc, const char* argv[]) {
   JsonTest::Runner runner;
   JSONTEST_REGISTER_FIXTURE(runner, ValueTest, checkNormalizeFloatingPointStr);
@@ -1639,6 +3034,10 @@ int main(int argc, const char* argv[]) {
   JSONTEST_REGISTER_FIXTURE(runner, ValueTest, compareType);
   JSONTEST_REGISTER_FIXTURE(runner, ValueTest, offsetAccessors);
   JSONTEST_REGISTER_FIXTURE(runner, ValueTest, typeChecksThrowExceptions);
+  JSONTEST_REGISTER_FIXTURE(runner, ValueTest, arrayStorage);
+  JSONTEST_REGISTER_FIXTURE(runner, ValueTest, objectStorage);
+  JSONTEST_REGISTER_FIXTURE(runner, ValueTest, shortStrings);
+  JSONTEST_REGISTER_FIXTURE(runner, ValueTest, embeddedNul);
 
   JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, parseWithNoErrors);
   JSONTEST_REGISTER_FIXTURE(
@@ -1646,6 +3045,27 @@ int main(int argc, const char* argv[]) {
   JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, parseWithOneError);
   JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, parseChineseWithOneError);
   JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, parseWithDetailError);
+  JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, parseLongStringsAndWhitespace);
+  JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, parseWithHandler);
+  JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, parseWithCursor);
+  JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, parseIncrementally);
+  JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, parseInSitu);
+  JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, parseDoubles);
+  JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, parseIntegers);
+  JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, parseWithStrictReader);
+  JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, parseWithMaxDepth);
+  JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, parseFile);
+  JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, parseLines);
+  JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, parseInParallel);
+  JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, parseLazily);
+  JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, parseSelectedPaths);
+  JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, validate);
+  JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, parseInvalidUTF8);
+  JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, parseStringsIntoValues);
+  JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, reuseReader);
+  JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, parseInto);
+  JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, parseWithoutOffsets);
+  JSONTEST_REGISTER_FIXTURE(runner, ReaderTest, shareKeys);
 
   JSONTEST_REGISTER_FIXTURE(runner, WriterTest, dropNullPlaceholders);
 